@@ -3,13 +3,19 @@
 // ============================================================================
 
 #include <ruby.h>
+#include <ruby/thread.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Streams keep two pages decoded ahead; quarter-second pages hold a stereo
+// 48 kHz stream to ~190 KB instead of the default's 750 KB
+#define MA_RESOURCE_MANAGER_PAGE_SIZE_IN_MILLISECONDS 250
+
 #define MINIAUDIO_IMPLEMENTATION
 #include "miniaudio.h"
 #include "audio.h"
+#include "simd.h"
 
 // ============================================================================
 // Global Definitions
@@ -17,61 +23,87 @@
 
 ma_engine engine;
 ma_context context;
+ma_resource_manager resource_manager;
 ma_sound *sounds[MAX_SOUNDS];
+pending_load *pending_loads[MAX_SOUNDS];
+char *clip_paths[MAX_SOUNDS];
+ma_bool32 clip_streamed[MAX_SOUNDS];
+static ma_bool32 clip_engine_format[MAX_SOUNDS];  // Decoded at the engine's rate and channel count
+static ma_bool32 clip_registered[MAX_SOUNDS];     // PCM handed to the resource manager by us
+static VALUE memory_strings[MEMORY_VFS_MAX_FILES];
+static int memory_files[MAX_SOUNDS];              // Memory VFS index per clip, -1 if from disk
+static int clip_banks[MAX_SOUNDS];                // Sound bank per clip, -1 if none
+static ma_bool32 clip_indexed[MAX_SOUNDS];        // Clip can be found by clip_index
 ma_sound *channels[MAX_CHANNELS];
-multi_tap_delay_node *delay_nodes[MAX_CHANNELS];
-reverb_node *reverb_nodes[MAX_CHANNELS];
-ma_uint64 drain_until_frame[MAX_CHANNELS];
 static VALUE channel_freed_callback = Qnil;
 int sound_count = 0;
 int engine_initialized = 0;
 int context_initialized = 0;
 int using_null_backend = 0;
+int using_offline_engine = 0;
+
+// The playback device is ours rather than the engine's, so its config
+// (performance profile included) isn't limited to what ma_engine_config
+// passes through
+static ma_device device;
+static ma_performance_profile device_profile;  // Requested; the device doesn't keep it
+static int device_initialized = 0;
+
+static ma_bool32 load_is_busy(int clip_id);
+static ma_bool32 settle_load(int clip_id);
+static void wait_for_load(int clip_id);
+static void free_pending_load(pending_load *load);
+static void unload_collected_clips(void);
+static void unindex_clip(int clip_id);
+static void release_registered(int clip_id);
+static void release_bank(int bank);
+static void close_banks(void);
 
 // ============================================================================
-// Cleanup (called on Ruby exit)
+// Cleanup (called on Ruby exit, and by Audio.init before a restart)
 // ============================================================================
 
-static void cleanup_audio(VALUE unused)
+static void shutdown_audio(ma_bool32 at_exit)
 {
-    (void)unused;
-
     if (!engine_initialized) {
         return;
     }
 
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (channels[i] != NULL) {
-            ma_sound_stop(channels[i]);
-            ma_sound_uninit(channels[i]);
-            free(channels[i]);
-            channels[i] = NULL;
-        }
-
-        if (delay_nodes[i] != NULL) {
-            multi_tap_delay_uninit(delay_nodes[i]);
-            free(delay_nodes[i]);
-            delay_nodes[i] = NULL;
-        }
+    voice_pool_uninit();
+    reverb_bus_uninit_all();
 
-        if (reverb_nodes[i] != NULL) {
-            reverb_uninit(reverb_nodes[i]);
-            free(reverb_nodes[i]);
-            reverb_nodes[i] = NULL;
-        }
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        channels[i] = NULL;
     }
+    channel_alloc_reset();
 
     for (int i = 0; i < sound_count; i++) {
+        // A job thread may still be decoding into the sound
+        if (pending_loads[i] != NULL) {
+            ma_fence_wait(&pending_loads[i]->done);
+            free_pending_load(pending_loads[i]);
+            pending_loads[i] = NULL;
+        }
+
         if (sounds[i] != NULL) {
             ma_sound_stop(sounds[i]);
             ma_sound_uninit(sounds[i]);
             free(sounds[i]);
             sounds[i] = NULL;
         }
+
+        release_registered(i);
+        free(clip_paths[i]);
+        clip_paths[i] = NULL;
+        clip_indexed[i] = MA_FALSE;
     }
+    clip_registry_reset();
+    clip_index_reset();
+    close_banks();
 
 #ifdef _WIN32
-    if (using_null_backend) {
+    // Only skipped at exit: a restart opens a new engine over this one
+    if (at_exit && using_null_backend) {
         engine_initialized = 0;
         context_initialized = 0;
         return;
@@ -79,6 +111,12 @@ static void cleanup_audio(VALUE unused)
 #endif
 
     ma_engine_uninit(&engine);
+    if (device_initialized) {
+        ma_device_uninit(&device);
+        device_initialized = 0;
+    }
+    ma_resource_manager_uninit(&resource_manager);
+    memory_vfs_reset();
     engine_initialized = 0;
 
     if (context_initialized) {
@@ -87,37 +125,263 @@ static void cleanup_audio(VALUE unused)
     }
 }
 
+static void cleanup_audio(VALUE unused)
+{
+    (void)unused;
+    shutdown_audio(MA_TRUE);
+}
+
 // ============================================================================
 // Engine Initialization
 // ============================================================================
 
-VALUE audio_init(VALUE self)
+static int end_proc_registered = 0;
+
+static VALUE sym_sample_rate, sym_period_ms, sym_channels, sym_profile, sym_backend;
+static VALUE sym_voices, sym_effects, sym_low_latency, sym_conservative;
+
+// Names Audio.init and NATIVE_AUDIO_DRIVER take for each backend, besides
+// "offline" for no device at all
+static const struct {
+    ma_backend backend;
+    const char *name;
+} backend_names[] = {
+    { ma_backend_wasapi,     "wasapi" },
+    { ma_backend_dsound,     "dsound" },
+    { ma_backend_winmm,      "winmm" },
+    { ma_backend_coreaudio,  "coreaudio" },
+    { ma_backend_sndio,      "sndio" },
+    { ma_backend_audio4,     "audio4" },
+    { ma_backend_oss,        "oss" },
+    { ma_backend_pulseaudio, "pulseaudio" },
+    { ma_backend_alsa,       "alsa" },
+    { ma_backend_jack,       "jack" },
+    { ma_backend_aaudio,     "aaudio" },
+    { ma_backend_opensl,     "opensl" },
+    { ma_backend_webaudio,   "webaudio" },
+    { ma_backend_null,       "null" }
+};
+
+#define BACKEND_NAME_COUNT (sizeof(backend_names) / sizeof(backend_names[0]))
+
+// Settings for Audio.init. Zero leaves the choice to the device.
+typedef struct {
+    const char *backend;    // NULL picks the platform's default
+    ma_uint32 sample_rate;
+    ma_uint32 channels;
+    ma_uint32 period_ms;
+    ma_performance_profile profile;
+    int voices;             // Channels, each with its voice made up front
+    int effects;            // Delay and reverb nodes made up front
+} init_options;
+
+static int init_count_option(VALUE value, const char *name)
+{
+    int count = NUM2INT(value);
+    if (count < 1 || count > MAX_CHANNELS) {
+        rb_raise(rb_eArgError, "%s must be between 1 and %d", name, MAX_CHANNELS);
+    }
+
+    return count;
+}
+
+static int parse_init_option(VALUE key, VALUE value, VALUE arg)
+{
+    init_options *options = (init_options *)arg;
+
+    if (key == sym_backend) {
+        options->backend = NIL_P(value) ? NULL : rb_id2name(SYM2ID(rb_to_symbol(value)));
+    } else if (key == sym_sample_rate) {
+        options->sample_rate = NIL_P(value) ? 0 : NUM2UINT(value);
+        if (options->sample_rate != 0 &&
+            (options->sample_rate < ma_standard_sample_rate_min || options->sample_rate > ma_standard_sample_rate_max)) {
+            rb_raise(rb_eArgError, "sample_rate must be between %d and %d",
+                     ma_standard_sample_rate_min, ma_standard_sample_rate_max);
+        }
+    } else if (key == sym_channels) {
+        options->channels = NIL_P(value) ? 0 : NUM2UINT(value);
+        if (options->channels > MA_MAX_CHANNELS) {
+            rb_raise(rb_eArgError, "channels must be at most %d", MA_MAX_CHANNELS);
+        }
+    } else if (key == sym_period_ms) {
+        options->period_ms = NIL_P(value) ? 0 : NUM2UINT(value);
+    } else if (key == sym_voices) {
+        options->voices = init_count_option(value, "voices");
+    } else if (key == sym_effects) {
+        options->effects = init_count_option(value, "effects");
+    } else if (key == sym_profile) {
+        if (value == sym_low_latency || NIL_P(value)) {
+            options->profile = ma_performance_profile_low_latency;
+        } else if (value == sym_conservative) {
+            options->profile = ma_performance_profile_conservative;
+        } else {
+            rb_raise(rb_eArgError, "profile must be :low_latency or :conservative, got %"PRIsVALUE, rb_inspect(value));
+        }
+    } else {
+        rb_raise(rb_eArgError, "Unknown init option: %"PRIsVALUE, rb_inspect(key));
+    }
+
+    return ST_CONTINUE;
+}
+
+static void device_data_callback(ma_device *pDevice, void *pFramesOut, const void *pFramesIn, ma_uint32 frameCount)
+{
+    (void)pDevice;
+    (void)pFramesIn;
+
+    ma_engine_read_pcm_frames(&engine, pFramesOut, frameCount, NULL);
+}
+
+// Opens the playback device the way the engine would, plus the profile.
+// Raises with whatever was set up so far released.
+static void init_device(const init_options *options)
+{
+    ma_device_config device_config = ma_device_config_init(ma_device_type_playback);
+    device_config.playback.format = ma_format_f32;
+    device_config.playback.channels = options->channels;
+    device_config.sampleRate = options->sample_rate;
+    device_config.periodSizeInMilliseconds = options->period_ms;
+    device_config.performanceProfile = options->profile;
+    device_config.dataCallback = device_data_callback;
+    device_config.noPreSilencedOutputBuffer = MA_TRUE;  // The engine writes every frame
+    device_config.noClip = MA_TRUE;                     // and clips itself
+
+    ma_result result = ma_device_init(context_initialized ? &context : NULL, &device_config, &device);
+    if (result != MA_SUCCESS) {
+        if (context_initialized) {
+            ma_context_uninit(&context);
+            context_initialized = 0;
+        }
+        rb_raise(rb_eRuntimeError, "Failed to open audio device: %s", ma_result_description(result));
+    }
+    device_profile = options->profile;
+    device_initialized = 1;
+}
+
+// Audio.init(options = {}) - starts the engine. Options (all optional):
+//   backend: :offline, :null or a device backend such as :alsa or :wasapi
+//            (defaults to NATIVE_AUDIO_DRIVER, then the platform's choice)
+//   sample_rate:, channels:  requested from the device (offline: 48000, 2)
+//   period_ms:  device period; the engine mixes a period at a time
+//   profile: :low_latency (default) or :conservative, which picks larger
+//            default periods for fewer wakeups
+//   voices:  channels there are (default NATIVE_AUDIO_VOICES, then 1024)
+//   effects: delay and reverb nodes (default 16); when all are in use,
+//            draining tails are cut to free one
+// Devices may not grant what's asked; Audio.engine_info has what they did.
+// Called again with options before any clip or bus exists, it restarts
+// the engine with them.
+VALUE audio_init(int argc, VALUE *argv, VALUE self)
 {
+    VALUE options_hash;
+    rb_scan_args(argc, argv, "01", &options_hash);
+
+    const char *voices_env = getenv("NATIVE_AUDIO_VOICES");
+    init_options options = { NULL, 0, 0, 0, ma_performance_profile_low_latency, MAX_CHANNELS, DEFAULT_EFFECT_POOL_SIZE };
+    options.backend = getenv("NATIVE_AUDIO_DRIVER");
+    if (voices_env != NULL && atoi(voices_env) > 0) {
+        options.voices = atoi(voices_env) < MAX_CHANNELS ? atoi(voices_env) : MAX_CHANNELS;
+    }
+
+    if (!NIL_P(options_hash)) {
+        Check_Type(options_hash, T_HASH);
+        rb_hash_foreach(options_hash, parse_init_option, (VALUE)&options);
+    }
+
     if (engine_initialized) {
-        return Qnil;
+        if (NIL_P(options_hash)) {
+            return Qnil;
+        }
+        // Clips already collected don't count, nor do unloaded ones no
+        // voice still plays
+        unload_collected_clips();
+        if (clip_registry_live_count() > 0 || reverb_bus_get(0) != NULL) {
+            rb_raise(rb_eRuntimeError, "Audio.init options must be given while no clips are loaded");
+            return Qnil;
+        }
+        shutdown_audio(MA_FALSE);
     }
 
-    const char *driver = getenv("NATIVE_AUDIO_DRIVER");
-    int use_null = (driver != NULL && strcmp(driver, "null") == 0);
+    int use_offline = (options.backend != NULL && strcmp(options.backend, "offline") == 0);
+    int use_null = (options.backend != NULL && strcmp(options.backend, "null") == 0);
+    using_offline_engine = 0;
+    using_null_backend = 0;
 
     ma_engine_config config = ma_engine_config_init();
     config.listenerCount = 1;
 
-    if (use_null) {
-        ma_backend backends[] = { ma_backend_null };
-        ma_result ctx_result = ma_context_init(backends, 1, NULL, &context);
+    if (use_offline) {
+        // No device: the graph only advances when Audio.render pulls frames
+        config.noDevice = MA_TRUE;
+        config.channels = options.channels != 0 ? options.channels : OFFLINE_CHANNELS;
+        config.sampleRate = options.sample_rate != 0 ? options.sample_rate : OFFLINE_SAMPLE_RATE;
+        config.periodSizeInFrames = options.period_ms * config.sampleRate / 1000;
+        using_offline_engine = 1;
+    } else if (options.backend != NULL) {
+        ma_backend backend = ma_backend_null;
+        size_t i;
+        for (i = 0; i < BACKEND_NAME_COUNT; i++) {
+            if (strcmp(options.backend, backend_names[i].name) == 0) {
+                backend = backend_names[i].backend;
+                break;
+            }
+        }
+        if (i == BACKEND_NAME_COUNT) {
+            rb_raise(rb_eArgError, "Unknown audio backend: %s", options.backend);
+            return Qnil;
+        }
+
+        ma_result ctx_result = ma_context_init(&backend, 1, NULL, &context);
         if (ctx_result != MA_SUCCESS) {
-            rb_raise(rb_eRuntimeError, "Failed to initialize null audio context");
+            rb_raise(rb_eRuntimeError, "Failed to initialize %s audio context", options.backend);
             return Qnil;
         }
         context_initialized = 1;
-        using_null_backend = 1;
-        config.pContext = &context;
+        using_null_backend = use_null;
+    }
+
+    // The device opens first: when it can't, there's only the context to
+    // release, not the resource manager's job threads as well
+    if (!use_offline) {
+        init_device(&options);
+        config.pDevice = &device;
+    }
+
+    // Our own resource manager so background decodes get more than the
+    // single job thread the engine would create
+    const char *threads_env = getenv("NATIVE_AUDIO_LOAD_THREADS");
+    int load_threads = threads_env != NULL ? atoi(threads_env) : DEFAULT_LOAD_THREADS;
+    if (load_threads < 1) load_threads = 1;
+    if (load_threads > MAX_LOAD_THREADS) load_threads = MAX_LOAD_THREADS;
+
+    ma_resource_manager_config rm_config = ma_resource_manager_config_init();
+    rm_config.decodedFormat = ma_format_f32;
+    rm_config.decodedChannels = 0;  // Keep source channels for spatialization
+    rm_config.jobThreadCount = (ma_uint32)load_threads;
+    rm_config.pVFS = memory_vfs_get();  // Files on disk, plus clips held in Ruby strings
+
+    if (ma_resource_manager_init(&rm_config, &resource_manager) != MA_SUCCESS) {
+        if (device_initialized) {
+            ma_device_uninit(&device);
+            device_initialized = 0;
+        }
+        if (context_initialized) {
+            ma_context_uninit(&context);
+            context_initialized = 0;
+        }
+        rb_raise(rb_eRuntimeError, "Failed to initialize resource manager");
+        return Qnil;
     }
+    config.pResourceManager = &resource_manager;
 
     ma_result result = ma_engine_init(&config, &engine);
 
     if (result != MA_SUCCESS) {
+        if (device_initialized) {
+            ma_device_uninit(&device);
+            device_initialized = 0;
+        }
+        ma_resource_manager_uninit(&resource_manager);
         if (context_initialized) {
             ma_context_uninit(&context);
             context_initialized = 0;
@@ -126,289 +390,1880 @@ VALUE audio_init(VALUE self)
         return Qnil;
     }
 
+    // The device rate is only known now. Decoders read this when a load
+    // starts, so clips are still resampled once up front, as the engine's
+    // built-in resource manager would do.
+    resource_manager.config.decodedSampleRate = ma_engine_get_sample_rate(&engine);
+
     engine_initialized = 1;
-    rb_set_end_proc(cleanup_audio, Qnil);
+    if (!end_proc_registered) {
+        rb_set_end_proc(cleanup_audio, Qnil);
+        end_proc_registered = 1;
+    }
+
+    // Every voice and effect node is made now, so play doesn't touch the
+    // heap. Channels past the voices are never handed out.
+    if (voice_pool_init(&engine, options.voices, options.effects) != MA_SUCCESS) {
+        // Takes down what of the pool was made along with the engine
+        shutdown_audio(MA_FALSE);
+        rb_raise(rb_eRuntimeError, "Failed to preallocate voice pool");
+        return Qnil;
+    }
+    channel_alloc_set_limit(options.voices);
+    channel_alloc_reset();
 
     return Qnil;
 }
 
-// ============================================================================
-// Audio Loading
-// ============================================================================
-
-VALUE audio_load(VALUE self, VALUE file)
+// Audio.engine_info - what the engine is actually running at, which for a
+// device is what it granted rather than what Audio.init asked for
+VALUE audio_engine_info(VALUE self)
 {
-    const char *path = StringValueCStr(file);
-
-    ma_sound *sound = (ma_sound *)malloc(sizeof(ma_sound));
-    if (sound == NULL) {
-        rb_raise(rb_eRuntimeError, "Failed to allocate memory for sound");
+    if (!engine_initialized) {
         return Qnil;
     }
 
-    ma_result result = ma_sound_init_from_file(&engine, path, MA_SOUND_FLAG_DECODE, NULL, NULL, sound);
-    if (result != MA_SUCCESS) {
-        free(sound);
-        rb_raise(rb_eRuntimeError, "Failed to load audio file: %s", path);
-        return Qnil;
+    VALUE info = rb_hash_new();
+    rb_hash_aset(info, sym_sample_rate, UINT2NUM(ma_engine_get_sample_rate(&engine)));
+    rb_hash_aset(info, sym_channels, UINT2NUM(ma_engine_get_channels(&engine)));
+    rb_hash_aset(info, sym_voices, INT2NUM(voice_pool_size()));
+
+    if (!device_initialized) {
+        rb_hash_aset(info, sym_backend, ID2SYM(rb_intern("offline")));
+        return info;
     }
 
-    int id = sound_count;
-    sounds[id] = sound;
-    sound_count++;
+    VALUE backend = Qnil;
+    for (size_t i = 0; i < BACKEND_NAME_COUNT; i++) {
+        if (backend_names[i].backend == device.pContext->backend) {
+            backend = ID2SYM(rb_intern(backend_names[i].name));
+            break;
+        }
+    }
+
+    ma_uint32 period_frames = device.playback.internalPeriodSizeInFrames;
+    rb_hash_aset(info, sym_backend, backend);
+    rb_hash_aset(info, ID2SYM(rb_intern("device_name")), rb_str_new_cstr(device.playback.name));
+    rb_hash_aset(info, sym_profile, device_profile == ma_performance_profile_conservative
+                                        ? sym_conservative : sym_low_latency);
+    rb_hash_aset(info, ID2SYM(rb_intern("period_frames")), UINT2NUM(period_frames));
+    rb_hash_aset(info, sym_period_ms, DBL2NUM(period_frames * 1000.0 / device.playback.internalSampleRate));
+    rb_hash_aset(info, ID2SYM(rb_intern("periods")), UINT2NUM(device.playback.internalPeriods));
 
-    return rb_int2inum(id);
+    return info;
 }
 
-VALUE audio_duration(VALUE self, VALUE clip)
+// Audio.stop_device / Audio.start_device - halts the device and the engine
+// clock with it, e.g. while the app is in the background. Audio.render
+// still works and leaves the device stopped.
+VALUE audio_stop_device(VALUE self)
 {
-    int clip_id = NUM2INT(clip);
-
-    if (clip_id < 0 || clip_id >= sound_count || sounds[clip_id] == NULL) {
-        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
-        return Qnil;
+    if (device_initialized) {
+        ma_engine_stop(&engine);
     }
 
-    float length;
-    ma_result result = ma_sound_get_length_in_seconds(sounds[clip_id], &length);
-    if (result != MA_SUCCESS) {
-        return Qnil;
+    return Qnil;
+}
+
+VALUE audio_start_device(VALUE self)
+{
+    if (device_initialized) {
+        ma_engine_start(&engine);
     }
 
-    return rb_float_new(length);
+    return Qnil;
 }
 
 // ============================================================================
-// Playback Controls
+// Clip Registry
 // ============================================================================
 
-static void cleanup_finished_channels(int skip_channel)
+// Loaded and not unloaded. An evicted clip is still valid: its sound is
+// NULL until the next play decodes it again.
+static ma_bool32 clip_id_valid(int clip_id)
 {
-    ma_uint64 now = ma_engine_get_time_in_pcm_frames(&engine);
-    ma_uint32 sample_rate = ma_engine_get_sample_rate(&engine);
-    ma_uint64 drain_frames = (ma_uint64)(REVERB_DRAIN_SECONDS * sample_rate);
-
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (i == skip_channel) continue;
-        // Phase 1: sound finished - uninit the sound, start drain timer
-        if (channels[i] != NULL && ma_sound_at_end(channels[i]) && !ma_sound_is_looping(channels[i])) {
-            ma_sound_uninit(channels[i]);
-            free(channels[i]);
-            channels[i] = NULL;
-            drain_until_frame[i] = now + drain_frames;
-
-            if (channel_freed_callback != Qnil) {
-                rb_funcall(channel_freed_callback, rb_intern("call"), 1, INT2NUM(i));
-            }
-        }
-
-        // Phase 2: drain timer expired - uninit delay and reverb nodes
-        if (drain_until_frame[i] != 0 && now >= drain_until_frame[i]) {
-            if (delay_nodes[i] != NULL) {
-                multi_tap_delay_uninit(delay_nodes[i]);
-                free(delay_nodes[i]);
-                delay_nodes[i] = NULL;
-            }
+    return clip_id >= 0 && clip_id < sound_count && clip_registry_is_loaded(clip_id);
+}
 
-            if (reverb_nodes[i] != NULL) {
-                reverb_uninit(reverb_nodes[i]);
-                free(reverb_nodes[i]);
-                reverb_nodes[i] = NULL;
-            }
+// Called before every load: unloads clips whose handles were collected,
+// then makes sure a slot is left
+static void clip_slot_check(void)
+{
+    unload_collected_clips();
 
-            drain_until_frame[i] = 0;
-        }
+    if (clip_registry_full()) {
+        rb_raise(rb_eRuntimeError, "Too many clips loaded (max %d)", MAX_SOUNDS);
     }
 }
 
-VALUE audio_play(VALUE self, VALUE channel_id, VALUE clip)
+// Takes a slot for a freshly initialized sound. The path is kept to open
+// streams and to decode the clip again after it's been evicted.
+static int clip_slot_fill(ma_sound *sound, char *path, ma_bool32 stream)
 {
-    int channel = NUM2INT(channel_id);
-    int clip_id = NUM2INT(clip);
+    int id = clip_registry_acquire();
 
-    if (clip_id < 0 || clip_id >= sound_count || sounds[clip_id] == NULL) {
-        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
-        return Qnil;
+    sounds[id] = sound;
+    clip_paths[id] = path;
+    clip_streamed[id] = stream;
+    clip_engine_format[id] = MA_FALSE;
+    clip_registered[id] = MA_FALSE;
+    memory_files[id] = -1;
+    clip_banks[id] = -1;
+    if (id >= sound_count) {
+        sound_count = id + 1;
     }
 
-    if (channel < 0 || channel >= MAX_CHANNELS) {
-        rb_raise(rb_eArgError, "Invalid channel ID: %d", channel);
-        return Qnil;
+    // Streams are never evicted; they only hold a couple of pages
+    if (!stream) {
+        clip_registry_make_resident(id);
     }
 
-    cleanup_finished_channels(channel);
+    return id;
+}
 
-    // Cancel any pending drain timer for this channel
-    drain_until_frame[channel] = 0;
+static void unpin_memory_file(int index)
+{
+    // Bank entries point into the bank's mapping instead
+    if (!NIL_P(memory_strings[index])) {
+        rb_gc_unregister_address(&memory_strings[index]);
+        memory_strings[index] = Qnil;
+    }
+    memory_vfs_remove(index);
+}
 
-    // Clean up existing resources on this channel
-    if (channels[channel] != NULL) {
-        ma_sound_stop(channels[channel]);
-        ma_sound_uninit(channels[channel]);
-        free(channels[channel]);
-        channels[channel] = NULL;
+// Releases what a clip kept alive for its voices once the last one is gone
+static void free_clip_slot(int clip_id)
+{
+    release_registered(clip_id);
+    free(clip_paths[clip_id]);
+    clip_paths[clip_id] = NULL;
+
+    if (memory_files[clip_id] >= 0) {
+        unpin_memory_file(memory_files[clip_id]);
+        memory_files[clip_id] = -1;
     }
 
-    if (delay_nodes[channel] != NULL) {
-        multi_tap_delay_uninit(delay_nodes[channel]);
-        free(delay_nodes[channel]);
-        delay_nodes[channel] = NULL;
+    if (clip_banks[clip_id] >= 0) {
+        release_bank(clip_banks[clip_id]);
+        clip_banks[clip_id] = -1;
     }
+}
 
-    if (reverb_nodes[channel] != NULL) {
-        reverb_uninit(reverb_nodes[channel]);
-        free(reverb_nodes[channel]);
-        reverb_nodes[channel] = NULL;
+static void clip_release(int clip_id)
+{
+    if (clip_registry_release(clip_id)) {
+        free_clip_slot(clip_id);
     }
+}
 
-    // Create sound copy for playback
-    ma_sound *playback = (ma_sound *)malloc(sizeof(ma_sound));
-    if (playback == NULL) {
-        rb_raise(rb_eRuntimeError, "Failed to allocate memory for playback");
-        return Qnil;
+// Drops the voice's copy of an unloaded clip, which is what finally lets
+// the resource manager free the decoded audio
+static void voice_drop_retired_clip(voice *v)
+{
+    if (v == NULL || v->attached || v->clip_id < 0 || clip_registry_is_loaded(v->clip_id)) {
+        return;
     }
 
-    ma_result result = ma_sound_init_copy(&engine, sounds[clip_id], MA_SOUND_FLAG_NO_DEFAULT_ATTACHMENT, NULL, playback);
-    if (result != MA_SUCCESS) {
-        free(playback);
-        rb_raise(rb_eRuntimeError, "Failed to create sound copy for playback");
-        return Qnil;
+    int clip_id = v->clip_id;
+    voice_release_clip(v);
+    clip_release(clip_id);
+}
+
+static void unload_clip(int clip_id)
+{
+    unindex_clip(clip_id);
+
+    if (sounds[clip_id] != NULL) {
+        ma_sound_uninit(sounds[clip_id]);
+        free(sounds[clip_id]);
+        sounds[clip_id] = NULL;
     }
 
-    // Create delay node
-    ma_uint32 sampleRate = ma_engine_get_sample_rate(&engine);
-    ma_uint32 numChannels = ma_engine_get_channels(&engine);
+    ma_bool32 freed = clip_registry_retire(clip_id);
 
-    multi_tap_delay_node *delayNode = (multi_tap_delay_node *)malloc(sizeof(multi_tap_delay_node));
-    if (delayNode == NULL) {
-        ma_sound_uninit(playback);
-        free(playback);
-        rb_raise(rb_eRuntimeError, "Failed to allocate memory for delay node");
-        return Qnil;
+    // Idle voices would otherwise keep their copy until they're reused;
+    // playing and draining ones let go when they're detached
+    for (int i = 0; i < MAX_CHANNELS && !freed; i++) {
+        voice *v = voice_pool_peek(i);
+        if (v != NULL && v->clip_id == clip_id && !v->attached) {
+            voice_release_clip(v);
+            freed = clip_registry_release(clip_id);
+        }
     }
 
-    result = multi_tap_delay_init(delayNode, ma_engine_get_node_graph(&engine), sampleRate, numChannels);
-    if (result != MA_SUCCESS) {
-        free(delayNode);
-        ma_sound_uninit(playback);
-        free(playback);
-        rb_raise(rb_eRuntimeError, "Failed to initialize delay node");
-        return Qnil;
+    if (freed) {
+        free_clip_slot(clip_id);
     }
+}
 
-    // Create reverb node
-    reverb_node *reverbNode = (reverb_node *)malloc(sizeof(reverb_node));
-    if (reverbNode == NULL) {
-        multi_tap_delay_uninit(delayNode);
-        free(delayNode);
-        ma_sound_uninit(playback);
-        free(playback);
-        rb_raise(rb_eRuntimeError, "Failed to allocate memory for reverb node");
-        return Qnil;
+// ============================================================================
+// Memory Budget
+// ============================================================================
+
+static ma_uint64 clip_memory_budget = 0;   // Decoded bytes, 0 for no limit
+
+// Records the decoded size of a resident clip. Called once its load has
+// settled, when the decoder knows the length; the size is kept while the
+// clip is evicted.
+static void measure_clip(int clip_id)
+{
+    if (sounds[clip_id] == NULL || clip_registry_bytes(clip_id) > 0) {
+        return;
     }
 
-    result = reverb_init(reverbNode, ma_engine_get_node_graph(&engine), sampleRate, numChannels);
-    if (result != MA_SUCCESS) {
-        free(reverbNode);
-        multi_tap_delay_uninit(delayNode);
-        free(delayNode);
-        ma_sound_uninit(playback);
-        free(playback);
-        rb_raise(rb_eRuntimeError, "Failed to initialize reverb node");
-        return Qnil;
+    ma_format format;
+    ma_uint32 clip_channels;
+    ma_uint64 frames;
+
+    if (ma_sound_get_data_format(sounds[clip_id], &format, &clip_channels, NULL, NULL, 0) != MA_SUCCESS ||
+        ma_sound_get_length_in_pcm_frames(sounds[clip_id], &frames) != MA_SUCCESS) {
+        return;
     }
 
-    // Route: sound -> delay_node -> reverb_node -> endpoint
-    ma_node *endpoint = ma_engine_get_endpoint(&engine);
-    ma_node_attach_output_bus(&reverbNode->base, 0, endpoint, 0);
-    ma_node_attach_output_bus(&delayNode->base, 0, &reverbNode->base, 0);
-    ma_node_attach_output_bus((ma_node *)playback, 0, &delayNode->base, 0);
+    clip_registry_set_bytes(clip_id, frames * clip_channels * ma_get_bytes_per_sample(format));
+}
+
+// Frees a clip's decoded audio but keeps its slot; the next play decodes
+// it again. Only called for clips no attached voice is using, so every
+// voice still holding a copy is idle.
+static void evict_clip(int clip_id)
+{
+    for (int i = 0; i < voice_pool_size() && clip_registry_idle_refs(clip_id) > 0; i++) {
+        voice *v = voice_pool_peek(i);
+        if (v != NULL && v->clip_id == clip_id && !v->attached) {
+            voice_release_clip(v);
+            clip_release(clip_id);
+        }
+    }
 
-    delay_nodes[channel] = delayNode;
-    reverb_nodes[channel] = reverbNode;
-    channels[channel] = playback;
-    ma_sound_start(playback);
+    ma_sound_uninit(sounds[clip_id]);
+    free(sounds[clip_id]);
+    sounds[clip_id] = NULL;
+    release_registered(clip_id);
 
-    return rb_int2inum(channel);
+    clip_registry_evict(clip_id);
 }
 
-VALUE audio_stop(VALUE self, VALUE channel_id)
+// Evicts least recently played clips until the decoded total fits the
+// budget. Clips that are playing, draining or still decoding stay.
+static void enforce_budget(void)
 {
-    int channel = NUM2INT(channel_id);
+    if (clip_memory_budget == 0 || clip_registry_resident_bytes() <= clip_memory_budget) {
+        return;
+    }
 
-    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
-        return Qnil;
+    int id = clip_registry_oldest();
+    while (id >= 0 && clip_registry_resident_bytes() > clip_memory_budget) {
+        int next = clip_registry_newer(id);
+
+        // A finished load can be settled without blocking
+        if (pending_loads[id] != NULL && !load_is_busy(id)) {
+            settle_load(id);
+        }
+
+        if (!clip_registry_in_use(id) && pending_loads[id] == NULL && clip_registry_is_resident(id)) {
+            evict_clip(id);
+        }
+
+        id = next;
     }
+}
 
-    ma_uint64 now = ma_engine_get_time_in_pcm_frames(&engine);
-    ma_uint32 sample_rate = ma_engine_get_sample_rate(&engine);
+// Audio.clip_memory_budget = bytes - caps the decoded audio kept in memory.
+// Over budget, the least recently played clips are evicted; 0 lifts the cap.
+VALUE audio_set_clip_memory_budget(VALUE self, VALUE bytes)
+{
+    clip_memory_budget = NUM2ULL(bytes);
+    enforce_budget();
 
-    ma_sound_stop(channels[channel]);
-    ma_sound_uninit(channels[channel]);
-    free(channels[channel]);
-    channels[channel] = NULL;
+    return bytes;
+}
 
-    drain_until_frame[channel] = now + (ma_uint64)(REVERB_DRAIN_SECONDS * sample_rate);
+VALUE audio_clip_memory_budget(VALUE self)
+{
+    return ULL2NUM(clip_memory_budget);
+}
 
-    return Qnil;
+// Audio.clip_memory_used - decoded bytes of every resident clip. A
+// background load counts once it has settled.
+VALUE audio_clip_memory_used(VALUE self)
+{
+    return ULL2NUM(clip_registry_resident_bytes());
 }
 
-VALUE audio_pause(VALUE self, VALUE channel_id)
+// ============================================================================
+// Deduplication
+// ============================================================================
+
+// Loading a file or string that's already loaded hands back the existing
+// clip with one more owner. File clips are keyed by their absolute path,
+// memory clips by their bytes; either way streamed and decoded loads of
+// the same audio stay separate clips, as do engine-format ones.
+static ma_uint64 clip_keys[MAX_SOUNDS];         // Index hash per clip
+
+typedef struct {
+    const char *path;
+    ma_bool32 stream;
+    ma_bool32 engine_format;
+} file_key;
+
+typedef struct {
+    const char *data;
+    size_t size;
+    ma_bool32 stream;
+    ma_bool32 engine_format;
+} memory_key;
+
+static ma_bool32 match_file(int clip_id, const void *pKey)
 {
-    int channel = NUM2INT(channel_id);
+    const file_key *key = (const file_key *)pKey;
 
-    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
-        return Qnil;
+    return memory_files[clip_id] < 0 && clip_streamed[clip_id] == key->stream &&
+           clip_engine_format[clip_id] == key->engine_format && strcmp(clip_paths[clip_id], key->path) == 0;
+}
+
+static ma_bool32 match_memory(int clip_id, const void *pKey)
+{
+    const memory_key *key = (const memory_key *)pKey;
+    int index = memory_files[clip_id];
+
+    if (index < 0 || clip_streamed[clip_id] != key->stream || clip_engine_format[clip_id] != key->engine_format) {
+        return MA_FALSE;
     }
 
-    ma_sound_stop(channels[channel]);
+    VALUE pinned = memory_strings[index];
+    return (size_t)RSTRING_LEN(pinned) == key->size && memcmp(RSTRING_PTR(pinned), key->data, key->size) == 0;
+}
 
-    return Qnil;
+static ma_uint64 hash_file_key(const file_key *key)
+{
+    return clip_index_hash(key->path, strlen(key->path), key->stream | (key->engine_format << 1));
 }
 
-VALUE audio_resume(VALUE self, VALUE channel_id)
+static ma_uint64 hash_memory_key(const memory_key *key)
 {
-    int channel = NUM2INT(channel_id);
+    return clip_index_hash(key->data, key->size, key->stream | (key->engine_format << 1));
+}
 
-    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
-        return Qnil;
+// Relative paths and "." or ".." segments would otherwise make one file
+// look like several
+static VALUE canonical_path(VALUE file)
+{
+    return rb_file_expand_path(StringValue(file), Qnil);
+}
+
+static void index_clip(int clip_id, ma_uint64 hash)
+{
+    clip_keys[clip_id] = hash;
+    clip_indexed[clip_id] = MA_TRUE;
+    clip_index_insert(hash, clip_id);
+}
+
+static void unindex_clip(int clip_id)
+{
+    if (clip_indexed[clip_id]) {
+        clip_index_remove(clip_keys[clip_id], clip_id);
+        clip_indexed[clip_id] = MA_FALSE;
     }
+}
 
-    ma_sound_start(channels[channel]);
+// Hands an already loaded clip to another load. Synchronous loads wait
+// out a first decode still in flight, so they fail the same way.
+static VALUE share_clip(int clip_id, ma_bool32 wait)
+{
+    clip_registry_own(clip_id);
 
-    return Qnil;
+    if (wait && pending_loads[clip_id] != NULL && !pending_loads[clip_id]->reload) {
+        wait_for_load(clip_id);
+    }
+
+    return rb_int2inum(clip_id);
 }
 
 // ============================================================================
-// Sound Effects
+// Registered Clips
 // ============================================================================
 
-VALUE audio_set_volume(VALUE self, VALUE channel_id, VALUE volume)
+// Clips whose PCM is found or decoded here rather than by the resource
+// manager, then handed to it as raw frames:
+//
+// - WAV files already in a playable format at the engine's sample rate.
+//   Their data chunk is mapped and played in place: loading is O(1) and
+//   the memory is shared with the OS file cache. WAVs loaded from memory
+//   or a sound bank play in place the same way.
+// - Engine-format clips. The resource manager already decodes at the
+//   engine's sample rate, but each voice still runs its resampler (at a
+//   ratio of 1) and upmixes mono. These are decoded to the engine's channel
+//   count as well, so their voices can skip the resampler until pitched.
+// - Files loaded while the PCM cache is on. The decode is written to the
+//   cache directory, and later launches map the cache file instead of
+//   decoding again.
+typedef struct {
+    float *pcm;                 // Decoded here, NULL if mapped
+    mapped_pcm mapped;          // Mapped WAV or cache file, map.pData NULL if none
+    char name[REGISTERED_NAME_CAP];
+} registered_audio;
+
+static registered_audio registered[MAX_SOUNDS];
+static ma_uint32 registered_serial = 0;
+
+// Decodes the whole file to 32-bit float at the engine's sample rate.
+// channels is the count to convert to, 0 to keep the source's.
+static ma_result decode_whole(const char *path, ma_uint32 channels, float **ppFrames,
+                              ma_uint64 *pFrameCount, ma_uint32 *pChannels)
 {
-    int channel = NUM2INT(channel_id);
-    int vol = NUM2INT(volume);
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, channels, ma_engine_get_sample_rate(&engine));
+    ma_decoder decoder;
 
-    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
-        return Qnil;
+    ma_result result = ma_decoder_init_vfs(memory_vfs_get(), path, &config, &decoder);
+    if (result != MA_SUCCESS) {
+        return result;
     }
 
-    ma_sound_set_volume(channels[channel], vol / 128.0f);
+    ma_uint32 out_channels = decoder.outputChannels;
+    ma_uint64 capacity = 0;
+    ma_uint64 frames = 0;
+    float *pFrames = NULL;
 
-    return Qnil;
-}
+    // Formats that don't know their length up front grow the buffer
+    if (ma_decoder_get_length_in_pcm_frames(&decoder, &capacity) != MA_SUCCESS || capacity == 0) {
+        capacity = ma_engine_get_sample_rate(&engine);
+    }
 
-VALUE audio_set_pitch(VALUE self, VALUE channel_id, VALUE pitch)
-{
-    int channel = NUM2INT(channel_id);
-    float p = (float)NUM2DBL(pitch);
+    for (;;) {
+        if (frames == capacity || pFrames == NULL) {
+            if (pFrames != NULL) capacity *= 2;
 
-    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
-        return Qnil;
+            float *pGrown = (float *)realloc(pFrames, (size_t)(capacity * out_channels * sizeof(float)));
+            if (pGrown == NULL) {
+                result = MA_OUT_OF_MEMORY;
+                break;
+            }
+            pFrames = pGrown;
+        }
+
+        ma_uint64 read = 0;
+        result = ma_decoder_read_pcm_frames(&decoder, pFrames + frames * out_channels, capacity - frames, &read);
+        frames += read;
+
+        if (result == MA_AT_END || (result == MA_SUCCESS && read == 0)) {
+            result = MA_SUCCESS;
+            break;
+        }
+        if (result != MA_SUCCESS) {
+            break;
+        }
     }
 
-    ma_sound_set_pitch(channels[channel], p);
+    ma_decoder_uninit(&decoder);
+
+    if (result != MA_SUCCESS || frames == 0) {
+        free(pFrames);
+        return result != MA_SUCCESS ? result : MA_INVALID_FILE;
+    }
+
+    *ppFrames = pFrames;
+    *pFrameCount = frames;
+    *pChannels = out_channels;
+    return MA_SUCCESS;
+}
+
+static void release_audio(registered_audio *audio)
+{
+    if (audio->name[0] != '\0') {
+        ma_resource_manager_unregister_data(&resource_manager, audio->name);
+        audio->name[0] = '\0';
+    }
+
+    free(audio->pcm);
+    audio->pcm = NULL;
+    file_map_close(&audio->mapped.map);
+}
+
+static ma_bool32 is_memory_path(const char *path)
+{
+    return strncmp(path, MEMORY_VFS_PREFIX, strlen(MEMORY_VFS_PREFIX)) == 0;
+}
+
+// A playable WAV, read where it is: mapped from disk, or in the memory
+// VFS's buffer
+static ma_bool32 open_wav(const char *path, ma_uint32 channels, ma_uint32 rate, mapped_pcm *pPCM)
+{
+    const void *pData;
+    size_t size;
+
+    if (is_memory_path(path)) {
+        return memory_vfs_find(path, &pData, &size) && wav_parse(pData, size, channels, rate, pPCM);
+    }
+
+    return wav_map_open(path, channels, rate, pPCM);
+}
+
+// Loads path into sound from a playable WAV or cache file. Failing that, it
+// decodes the file if decode is set, and returns MA_DOES_NOT_EXIST if not
+// so the caller can leave it to the resource manager. Runs on the calling
+// thread, like any other synchronous load.
+static ma_result register_clip(const char *path, ma_uint32 channels, ma_bool32 decode,
+                               ma_sound *sound, registered_audio *audio)
+{
+    ma_uint32 rate = ma_engine_get_sample_rate(&engine);
+    const void *pFrames;
+    ma_uint64 frames;
+    ma_format format;
+    ma_uint32 frame_channels;
+
+    memset(audio, 0, sizeof(*audio));
+
+    if (open_wav(path, channels, rate, &audio->mapped) ||
+        pcm_cache_open(path, channels, rate, &audio->mapped)) {
+        pFrames = audio->mapped.pFrames;
+        frames = audio->mapped.frameCount;
+        format = audio->mapped.format;
+        frame_channels = audio->mapped.channels;
+    } else if (decode) {
+        ma_result result = decode_whole(path, channels, &audio->pcm, &frames, &frame_channels);
+        if (result != MA_SUCCESS) {
+            return result;
+        }
+        pFrames = audio->pcm;
+        format = ma_format_f32;
+
+        // A failed write only costs the next launch a decode
+        pcm_cache_store(path, channels, audio->pcm, frames, frame_channels, rate);
+    } else {
+        return MA_DOES_NOT_EXIST;
+    }
+
+    // Names are never reused, so a slot's new audio can't be mistaken for
+    // its old one
+    snprintf(audio->name, sizeof(audio->name), "native_audio:pcm/%u", registered_serial++);
+
+    ma_result result = ma_resource_manager_register_decoded_data(&resource_manager, audio->name, pFrames, frames,
+                                                                 format, frame_channels, rate);
+    if (result != MA_SUCCESS) {
+        audio->name[0] = '\0';
+    } else {
+        result = ma_sound_init_from_file(&engine, audio->name, MA_SOUND_FLAG_DECODE, NULL, NULL, sound);
+    }
+
+    if (result != MA_SUCCESS) {
+        release_audio(audio);
+    }
+
+    return result;
+}
+
+// Frees the audio once nothing plays it: the clip's own sound has been
+// uninitialized and no voice holds a copy
+static void release_registered(int clip_id)
+{
+    release_audio(&registered[clip_id]);
+}
+
+// Audio.pcm_cache_dir = dir - caches decoded clips in dir (which must
+// exist) across launches; nil turns the cache off
+VALUE audio_set_pcm_cache_dir(VALUE self, VALUE dir)
+{
+    if (NIL_P(dir)) {
+        pcm_cache_set_dir(NULL);
+        return Qnil;
+    }
+
+    const char *path = StringValueCStr(dir);
+    if (strlen(path) + 32 >= PCM_CACHE_PATH_CAP) {
+        rb_raise(rb_eArgError, "Cache directory path is too long");
+        return Qnil;
+    }
+
+    pcm_cache_set_dir(path);
+    return dir;
+}
+
+VALUE audio_pcm_cache_dir(VALUE self)
+{
+    const char *dir = pcm_cache_get_dir();
+    return dir != NULL ? rb_str_new_cstr(dir) : Qnil;
+}
+
+// ============================================================================
+// Audio Loading
+// ============================================================================
+
+static void raise_load_error(ma_result result, const char *path)
+{
+    if (result == MA_OUT_OF_MEMORY) {
+        rb_raise(rb_eRuntimeError, "Failed to allocate memory for sound");
+    }
+
+    rb_raise(rb_eRuntimeError, "Failed to load audio file: %s", path);
+}
+
+static char *copy_path(const char *path)
+{
+    char *copy = (char *)malloc(strlen(path) + 1);
+    if (copy != NULL) {
+        strcpy(copy, path);
+    }
+
+    return copy;
+}
+
+// Decodes the whole file up front, or with stream set, opens it for
+// streaming. Streamed clips decode a few pages ahead on the job threads
+// while playing; each play opens its own stream. engine_format decodes to
+// the engine's channel count too (see Registered Clips). The caller checks
+// for a free slot first.
+static ma_result load_clip(const char *path, ma_bool32 stream, ma_bool32 engine_format, int *pClipId)
+{
+    ma_sound *sound = (ma_sound *)malloc(sizeof(ma_sound));
+    char *path_copy = copy_path(path);
+    if (sound == NULL || path_copy == NULL) {
+        free(sound);
+        free(path_copy);
+        return MA_OUT_OF_MEMORY;
+    }
+
+    // Playable WAVs are read in place. Files on disk also go through the
+    // PCM cache when it's on; memory clips have no modification time to
+    // key it on.
+    registered_audio audio;
+    ma_uint32 channels = engine_format ? ma_engine_get_channels(&engine) : 0;
+    ma_bool32 decode = engine_format || (!is_memory_path(path) && pcm_cache_get_dir() != NULL);
+    ma_result result = MA_DOES_NOT_EXIST;
+
+    if (engine_format || !stream) {
+        result = register_clip(path, channels, decode, sound, &audio);
+    }
+
+    ma_bool32 use_registered = (result != MA_DOES_NOT_EXIST);
+    if (!use_registered) {
+        ma_uint32 flags = stream ? MA_SOUND_FLAG_STREAM : MA_SOUND_FLAG_DECODE;
+        result = ma_sound_init_from_file(&engine, path, flags, NULL, NULL, sound);
+    }
+    if (result != MA_SUCCESS) {
+        free(path_copy);
+        free(sound);
+        return result;
+    }
+
+    *pClipId = clip_slot_fill(sound, path_copy, stream);
+    clip_engine_format[*pClipId] = engine_format;
+    clip_registered[*pClipId] = use_registered;
+    if (use_registered) {
+        registered[*pClipId] = audio;
+    }
+    measure_clip(*pClipId);
+    return MA_SUCCESS;
+}
+
+// Streams are converted page by page as they play, so they can't be
+// engine-format
+static void check_load_mode(ma_bool32 stream, ma_bool32 engine_format)
+{
+    if (stream && engine_format) {
+        rb_raise(rb_eArgError, "Streamed clips can't be loaded in engine format");
+    }
+}
+
+// Audio.load(path, stream = false, engine_format = false)
+VALUE audio_load(int argc, VALUE *argv, VALUE self)
+{
+    VALUE file, stream_value, format_value;
+    rb_scan_args(argc, argv, "12", &file, &stream_value, &format_value);
+    check_load_mode(RTEST(stream_value), RTEST(format_value));
+
+    VALUE path_value = canonical_path(file);
+    file_key key = { StringValueCStr(path_value), RTEST(stream_value), RTEST(format_value) };
+    ma_uint64 hash = hash_file_key(&key);
+
+    unload_collected_clips();
+
+    int clip_id = clip_index_find(hash, match_file, &key);
+    if (clip_id >= 0) {
+        return share_clip(clip_id, MA_TRUE);
+    }
+
+    clip_slot_check();
+
+    ma_result result = load_clip(key.path, key.stream, key.engine_format, &clip_id);
+    if (result != MA_SUCCESS) {
+        raise_load_error(result, key.path);
+        return Qnil;
+    }
+
+    index_clip(clip_id, hash);
+    enforce_budget();
+    return rb_int2inum(clip_id);
+}
+
+// Drops owners from a clip, unloading it when none are left
+static void disown_clip(int clip_id, int count)
+{
+    int remaining = 0;
+    for (int i = 0; i < count; i++) {
+        remaining = clip_registry_disown(clip_id);
+    }
+
+    // A decode in flight still writes into the sound
+    if (remaining == 0 && settle_load(clip_id)) {
+        unload_clip(clip_id);
+    }
+}
+
+// ============================================================================
+// Clip Handles
+// ============================================================================
+
+// Ruby objects that give up their load's ownership of a clip when garbage
+// collected. Frees run inside the GC, so they only count the clip; the
+// counts are settled on the next load or play.
+typedef struct {
+    int clip_id;
+    ma_uint32 generation;
+    ma_bool32 released;        // Ownership already given up by Audio.unload
+} clip_handle;
+
+static int collected_owners[MAX_SOUNDS];     // Handles collected per clip
+static int collected_clips[MAX_SOUNDS];      // Clips with collected handles
+static int collected_count = 0;
+
+static void clip_handle_free(void *ptr)
+{
+    clip_handle *handle = (clip_handle *)ptr;
+    int clip_id = handle->clip_id;
+
+    // A generation mismatch means the slot has been reused since
+    if (!handle->released && clip_registry_generation(clip_id) == handle->generation) {
+        if (collected_owners[clip_id]++ == 0) {
+            collected_clips[collected_count++] = clip_id;
+        }
+    }
+
+    free(handle);
+}
+
+static size_t clip_handle_size(const void *ptr)
+{
+    (void)ptr;
+    return sizeof(clip_handle);
+}
+
+static const rb_data_type_t clip_handle_type = {
+    "Audio::ClipHandle",
+    { NULL, clip_handle_free, clip_handle_size, },
+    NULL, NULL,
+    RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE cClipHandle;
+
+static void unload_collected_clips(void)
+{
+    while (collected_count > 0) {
+        int clip_id = collected_clips[--collected_count];
+        int count = collected_owners[clip_id];
+
+        collected_owners[clip_id] = 0;
+        if (clip_registry_is_loaded(clip_id)) {
+            disown_clip(clip_id, count);
+        }
+    }
+}
+
+// Audio.unload(clip, handle = nil) - gives up one load's ownership of the
+// clip. Once every load of it has been unloaded, its slot and decoded audio
+// are freed; channels already playing it finish normally. Pass the clip's
+// handle, if it has one, so collecting it later doesn't count twice.
+VALUE audio_unload(int argc, VALUE *argv, VALUE self)
+{
+    VALUE clip, handle_value;
+    rb_scan_args(argc, argv, "11", &clip, &handle_value);
+
+    int clip_id = NUM2INT(clip);
+
+    if (!clip_id_valid(clip_id)) {
+        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
+        return Qnil;
+    }
+
+    if (!NIL_P(handle_value)) {
+        clip_handle *handle;
+        TypedData_Get_Struct(handle_value, clip_handle, &clip_handle_type, handle);
+
+        if (handle->released) {
+            return Qnil;
+        }
+        handle->released = MA_TRUE;
+    }
+
+    disown_clip(clip_id, 1);
+
+    return Qnil;
+}
+
+// Audio.clip_handle(clip) - an object that unloads the clip once it's
+// garbage collected, unless it was passed to Audio.unload first
+VALUE audio_clip_handle(VALUE self, VALUE clip)
+{
+    int clip_id = NUM2INT(clip);
+
+    if (!clip_id_valid(clip_id)) {
+        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
+        return Qnil;
+    }
+
+    clip_handle *handle = (clip_handle *)malloc(sizeof(clip_handle));
+    if (handle == NULL) {
+        rb_raise(rb_eNoMemError, "Failed to allocate clip handle");
+        return Qnil;
+    }
+
+    handle->clip_id = clip_id;
+    handle->generation = clip_registry_generation(clip_id);
+    handle->released = MA_FALSE;
+
+    return TypedData_Wrap_Struct(cClipHandle, &clip_handle_type, handle);
+}
+
+// ============================================================================
+// Asynchronous Loading
+// ============================================================================
+
+static ma_bool32 load_is_busy(int clip_id)
+{
+    return ma_resource_manager_data_source_result(sounds[clip_id]->pResourceManagerDataSource) == MA_BUSY;
+}
+
+// One Ruby thread's wait on a load, run without the GVL
+typedef struct {
+    pending_load *load;
+    ma_resource_manager_data_source *pDataSource;
+    volatile ma_bool32 cancelled;  // Set by the unblock function on interrupt
+    ma_bool32 finished;
+} load_wait;
+
+// Nothing but the job thread can wake a fence, so the decode is polled
+// in short slices, which lets an interrupt end the wait. Once it's done
+// the fence is waited on too, since the job thread may still hold it. A
+// fence only wakes one waiter, so threads waiting on the same clip take
+// turns; everyone after the first finds the counter already at zero.
+static void *wait_for_fence(void *pUserData)
+{
+    load_wait *wait = (load_wait *)pUserData;
+
+    while (ma_resource_manager_data_source_result(wait->pDataSource) == MA_BUSY) {
+        if (wait->cancelled) {
+            return NULL;
+        }
+        ma_sleep(LOAD_WAIT_SLICE_MS);
+    }
+
+    ma_mutex_lock(&wait->load->wait_lock);
+    ma_fence_wait(&wait->load->done);
+    ma_mutex_unlock(&wait->load->wait_lock);
+
+    wait->finished = MA_TRUE;
+    return NULL;
+}
+
+// Unblock function: Ctrl-C or Thread#kill ends the wait at the next slice
+static void cancel_load_wait(void *pUserData)
+{
+    load_wait *wait = (load_wait *)pUserData;
+    wait->cancelled = MA_TRUE;
+}
+
+static void free_pending_load(pending_load *load)
+{
+    ma_fence_uninit(&load->done);
+    ma_mutex_uninit(&load->wait_lock);
+    free(load);
+}
+
+// Waits out a background load, with the GVL released so other Ruby threads
+// keep running and Ctrl-C or Thread#kill can end the wait. Returns false if
+// the decode failed, in which case the clip has been unloaded.
+static ma_bool32 settle_load(int clip_id)
+{
+    pending_load *load = pending_loads[clip_id];
+    if (load == NULL) {
+        return MA_TRUE;
+    }
+
+    if (load_is_busy(clip_id)) {
+        load_wait wait = { load, sounds[clip_id]->pResourceManagerDataSource, MA_FALSE, MA_FALSE };
+
+        load->waiters++;
+        rb_thread_call_without_gvl2(wait_for_fence, &wait, cancel_load_wait, &wait);
+        load->waiters--;
+
+        // Interrupted: the bookkeeping is left as if this thread had never
+        // waited, then the interrupt raises. One that doesn't, such as a
+        // trap handler, leaves the wait to start over.
+        if (!wait.finished) {
+            ma_bool32 settled = pending_loads[clip_id] != load;
+            ma_bool32 loaded = !load->failed;
+            if (settled && load->waiters == 0) {
+                free_pending_load(load);
+            }
+
+            rb_thread_check_ints();
+            return settled ? loaded : settle_load(clip_id);
+        }
+    }
+
+    // Several threads can wait on one clip: the first back settles it,
+    // the last one out frees the bookkeeping
+    if (pending_loads[clip_id] == load) {
+        pending_loads[clip_id] = NULL;
+
+        if (ma_resource_manager_data_source_result(sounds[clip_id]->pResourceManagerDataSource) != MA_SUCCESS) {
+            load->failed = MA_TRUE;
+            unload_clip(clip_id);
+        } else {
+            measure_clip(clip_id);
+        }
+    }
+
+    ma_bool32 loaded = !load->failed;
+
+    if (load->waiters == 0) {
+        free_pending_load(load);
+    }
+
+    return loaded;
+}
+
+// settle_load, raising if the decode failed
+static void wait_for_load(int clip_id)
+{
+    if (pending_loads[clip_id] == NULL) {
+        return;
+    }
+
+    VALUE path = rb_str_new_cstr(clip_paths[clip_id]);
+
+    if (!settle_load(clip_id)) {
+        rb_raise(rb_eRuntimeError, "Failed to load audio file: %s", StringValueCStr(path));
+    }
+}
+
+// Starts decoding a sound on the resource manager's job threads
+static ma_result start_async_decode(const char *path, ma_sound **ppSound, pending_load **ppLoad)
+{
+    ma_sound *sound = (ma_sound *)malloc(sizeof(ma_sound));
+    pending_load *load = (pending_load *)malloc(sizeof(pending_load));
+    if (sound == NULL || load == NULL) {
+        free(sound);
+        free(load);
+        return MA_OUT_OF_MEMORY;
+    }
+
+    load->waiters = 0;
+    load->failed = MA_FALSE;
+    load->reload = MA_FALSE;
+    ma_fence_init(&load->done);
+    ma_mutex_init(&load->wait_lock);
+
+    ma_sound_config sound_config = ma_sound_config_init_2(&engine);
+    sound_config.pFilePath = path;
+    sound_config.flags = MA_SOUND_FLAG_DECODE | MA_SOUND_FLAG_ASYNC;
+    sound_config.initNotifications.done.pFence = &load->done;
+
+    ma_result result = ma_sound_init_ex(&engine, &sound_config, sound);
+    if (result != MA_SUCCESS) {
+        free_pending_load(load);
+        free(sound);
+        return result;
+    }
+
+    *ppSound = sound;
+    *ppLoad = load;
+    return MA_SUCCESS;
+}
+
+// Starts a load and returns the clip ID straight away. The caller checks
+// for a free slot first.
+static ma_result load_clip_async(const char *path, int *pClipId)
+{
+    ma_sound *sound;
+    pending_load *load;
+
+    char *path_copy = copy_path(path);
+    if (path_copy == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+
+    // Reading a playable WAV in place or mapping a cache file takes no
+    // time, so there's nothing to hand to the job threads
+    registered_audio audio;
+    sound = (ma_sound *)malloc(sizeof(ma_sound));
+
+    if (sound != NULL && register_clip(path, 0, MA_FALSE, sound, &audio) == MA_SUCCESS) {
+        int id = clip_slot_fill(sound, path_copy, MA_FALSE);
+        clip_registered[id] = MA_TRUE;
+        registered[id] = audio;
+        measure_clip(id);
+
+        *pClipId = id;
+        return MA_SUCCESS;
+    }
+    free(sound);
+
+    ma_result result = start_async_decode(path, &sound, &load);
+    if (result != MA_SUCCESS) {
+        free(path_copy);
+        return result;
+    }
+
+    int id = clip_slot_fill(sound, path_copy, MA_FALSE);
+    pending_loads[id] = load;
+
+    *pClipId = id;
+    return MA_SUCCESS;
+}
+
+// Registered clips are decoded (or mapped) as a whole, so they reload up
+// front
+static void reload_registered_clip(int clip_id)
+{
+    ma_sound *sound = (ma_sound *)malloc(sizeof(ma_sound));
+    if (sound == NULL) {
+        raise_load_error(MA_OUT_OF_MEMORY, clip_paths[clip_id]);
+        return;
+    }
+
+    ma_uint32 channels = clip_engine_format[clip_id] ? ma_engine_get_channels(&engine) : 0;
+    ma_result result = register_clip(clip_paths[clip_id], channels, MA_TRUE, sound, &registered[clip_id]);
+    if (result != MA_SUCCESS) {
+        free(sound);
+        raise_load_error(result, clip_paths[clip_id]);
+        return;
+    }
+
+    sounds[clip_id] = sound;
+    clip_registry_make_resident(clip_id);
+    measure_clip(clip_id);
+}
+
+// Decodes an evicted clip again. Playback can start right away: a copy of
+// a sound that's still decoding plays each page as it lands.
+static void reload_clip(int clip_id)
+{
+    if (sounds[clip_id] != NULL) {
+        return;
+    }
+
+    if (clip_registered[clip_id]) {
+        reload_registered_clip(clip_id);
+        return;
+    }
+
+    ma_result result = start_async_decode(clip_paths[clip_id], &sounds[clip_id], &pending_loads[clip_id]);
+    if (result != MA_SUCCESS) {
+        sounds[clip_id] = NULL;
+        pending_loads[clip_id] = NULL;
+        raise_load_error(result, clip_paths[clip_id]);
+        return;
+    }
+
+    pending_loads[clip_id]->reload = MA_TRUE;
+    clip_registry_make_resident(clip_id);
+}
+
+// Audio.load_async(path)
+VALUE audio_load_async(VALUE self, VALUE file)
+{
+    VALUE path_value = canonical_path(file);
+    file_key key = { StringValueCStr(path_value), MA_FALSE, MA_FALSE };
+    ma_uint64 hash = hash_file_key(&key);
+
+    unload_collected_clips();
+
+    int clip_id = clip_index_find(hash, match_file, &key);
+    if (clip_id >= 0) {
+        return share_clip(clip_id, MA_FALSE);
+    }
+
+    clip_slot_check();
+
+    ma_result result = load_clip_async(key.path, &clip_id);
+    if (result != MA_SUCCESS) {
+        raise_load_error(result, key.path);
+        return Qnil;
+    }
+
+    index_clip(clip_id, hash);
+    enforce_budget();
+    return rb_int2inum(clip_id);
+}
+
+// Audio.loaded?(clip) - true once the decode has finished (or failed;
+// wait_load reports which)
+VALUE audio_loaded(VALUE self, VALUE clip)
+{
+    int clip_id = NUM2INT(clip);
+
+    if (!clip_id_valid(clip_id)) {
+        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
+        return Qnil;
+    }
+
+    // Evicted clips count as loaded; they decode again when played
+    if (pending_loads[clip_id] == NULL || pending_loads[clip_id]->reload) {
+        return Qtrue;
+    }
+
+    return load_is_busy(clip_id) ? Qfalse : Qtrue;
+}
+
+VALUE audio_wait_load(VALUE self, VALUE clip)
+{
+    int clip_id = NUM2INT(clip);
+
+    if (!clip_id_valid(clip_id)) {
+        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
+        return Qnil;
+    }
+
+    wait_for_load(clip_id);
+
+    return Qnil;
+}
+
+static VALUE batch_start(VALUE file)
+{
+    return audio_load_async(Qnil, file);
+}
+
+// Takes [clip, path]. A path listed twice shares one clip, so the second
+// entry finds it already unloaded if its decode failed.
+static VALUE batch_wait(VALUE entry)
+{
+    VALUE clip = rb_ary_entry(entry, 0);
+    int clip_id = NUM2INT(clip);
+
+    wait_for_load(clip_id);
+
+    if (!clip_id_valid(clip_id)) {
+        VALUE path = rb_ary_entry(entry, 1);
+        rb_raise(rb_eRuntimeError, "Failed to load audio file: %s", StringValueCStr(path));
+    }
+
+    return clip;
+}
+
+// Runs one step of a batch, returning the error it raised instead of
+// raising it. Anything that isn't a StandardError (an interrupt, say)
+// still aborts the batch.
+static VALUE batch_step(VALUE (*step)(VALUE), VALUE arg)
+{
+    int state = 0;
+    VALUE result = rb_protect(step, arg, &state);
+
+    if (state != 0) {
+        VALUE error = rb_errinfo();
+        if (!rb_obj_is_kind_of(error, rb_eStandardError)) {
+            rb_jump_tag(state);
+        }
+
+        rb_set_errinfo(Qnil);
+        return error;
+    }
+
+    return result;
+}
+
+// Audio.load_batch(paths) - loads a list of files at once. Every decode is
+// queued before any is waited on, so they run in parallel across the job
+// threads. Returns one entry per path, in order: the clip ID, or the
+// exception its load raised.
+VALUE audio_load_batch(VALUE self, VALUE paths)
+{
+    Check_Type(paths, T_ARRAY);
+
+    long count = RARRAY_LEN(paths);
+    VALUE results = rb_ary_new_capa(count);
+
+    for (long i = 0; i < count; i++) {
+        rb_ary_push(results, batch_step(batch_start, rb_ary_entry(paths, i)));
+    }
+
+    for (long i = 0; i < count; i++) {
+        VALUE clip = rb_ary_entry(results, i);
+        if (FIXNUM_P(clip)) {
+            VALUE entry = rb_assoc_new(clip, rb_ary_entry(paths, i));
+            rb_ary_store(results, i, batch_step(batch_wait, entry));
+        }
+    }
+
+    return results;
+}
+
+// ============================================================================
+// In-Memory Loading
+// ============================================================================
+
+// Registers a Ruby string with the memory VFS and writes the name it opens
+// under into pName. A frozen copy (sharing the original's bytes) is pinned
+// until the clip is unloaded, so the decoder reads the string in place.
+// Returns the VFS index.
+static int pin_memory_file(VALUE data, VALUE format_hint, char *pName, size_t nameCap)
+{
+    StringValue(data);
+    const char *extension = NIL_P(format_hint) ? NULL : StringValueCStr(format_hint);
+
+    VALUE pinned = rb_str_new_frozen(data);
+    int index = memory_vfs_add(RSTRING_PTR(pinned), (size_t)RSTRING_LEN(pinned), extension, pName, nameCap);
+    if (index < 0) {
+        rb_raise(rb_eRuntimeError, "Too many clips loaded from memory (max %d)", MEMORY_VFS_MAX_FILES);
+        return -1;
+    }
+
+    // Registered addresses are marked as pinned, so compaction can't move
+    // the bytes out from under a job thread
+    memory_strings[index] = pinned;
+    rb_gc_register_address(&memory_strings[index]);
+
+    return index;
+}
+
+// Audio.load_memory(data, format_hint = nil, stream = false,
+// engine_format = false) - like load, but decodes an encoded file held in
+// a String. format_hint is a file extension ("wav", "ogg", ...) tried
+// first; without it every decoder is tried in turn.
+VALUE audio_load_memory(int argc, VALUE *argv, VALUE self)
+{
+    VALUE data, format_hint, stream_value, format_value;
+    rb_scan_args(argc, argv, "13", &data, &format_hint, &stream_value, &format_value);
+    check_load_mode(RTEST(stream_value), RTEST(format_value));
+
+    StringValue(data);
+    memory_key key = { RSTRING_PTR(data), (size_t)RSTRING_LEN(data), RTEST(stream_value), RTEST(format_value) };
+    ma_uint64 hash = hash_memory_key(&key);
+    char name[MEMORY_VFS_NAME_CAP];
+
+    unload_collected_clips();
+
+    int clip_id = clip_index_find(hash, match_memory, &key);
+    if (clip_id >= 0) {
+        return share_clip(clip_id, MA_TRUE);
+    }
+
+    clip_slot_check();
+    int index = pin_memory_file(data, format_hint, name, sizeof(name));
+
+    ma_result result = load_clip(name, key.stream, key.engine_format, &clip_id);
+    if (result != MA_SUCCESS) {
+        unpin_memory_file(index);
+        raise_load_error(result, "<memory>");
+        return Qnil;
+    }
+
+    memory_files[clip_id] = index;
+    index_clip(clip_id, hash);
+    enforce_budget();
+    return rb_int2inum(clip_id);
+}
+
+// Audio.load_memory_async(data, format_hint = nil)
+VALUE audio_load_memory_async(int argc, VALUE *argv, VALUE self)
+{
+    VALUE data, format_hint;
+    rb_scan_args(argc, argv, "11", &data, &format_hint);
+
+    StringValue(data);
+    memory_key key = { RSTRING_PTR(data), (size_t)RSTRING_LEN(data), MA_FALSE, MA_FALSE };
+    ma_uint64 hash = hash_memory_key(&key);
+    char name[MEMORY_VFS_NAME_CAP];
+
+    unload_collected_clips();
+
+    int clip_id = clip_index_find(hash, match_memory, &key);
+    if (clip_id >= 0) {
+        return share_clip(clip_id, MA_FALSE);
+    }
+
+    clip_slot_check();
+    int index = pin_memory_file(data, format_hint, name, sizeof(name));
+
+    ma_result result = load_clip_async(name, &clip_id);
+    if (result != MA_SUCCESS) {
+        unpin_memory_file(index);
+        raise_load_error(result, "<memory>");
+        return Qnil;
+    }
+
+    memory_files[clip_id] = index;
+    index_clip(clip_id, hash);
+    enforce_budget();
+    return rb_int2inum(clip_id);
+}
+
+VALUE audio_duration(VALUE self, VALUE clip)
+{
+    int clip_id = NUM2INT(clip);
+
+    if (!clip_id_valid(clip_id)) {
+        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
+        return Qnil;
+    }
+
+    reload_clip(clip_id);
+    wait_for_load(clip_id);
+
+    float length;
+    ma_result result = ma_sound_get_length_in_seconds(sounds[clip_id], &length);
+    if (result != MA_SUCCESS) {
+        return Qnil;
+    }
+
+    return rb_float_new(length);
+}
+
+// ============================================================================
+// Sound Banks
+// ============================================================================
+
+// A bank stays mapped while any clip loaded from it is alive. Its entries
+// are served by the memory VFS straight from the mapping.
+typedef struct {
+    file_map map;       // map.pData NULL if the slot is free
+    int clips;          // References: one per clip, plus the loader's
+} sound_bank;
+
+static sound_bank banks[MAX_BANKS];
+
+static void release_bank(int bank)
+{
+    if (--banks[bank].clips == 0) {
+        file_map_close(&banks[bank].map);
+    }
+}
+
+static void close_banks(void)
+{
+    for (int i = 0; i < MAX_BANKS; i++) {
+        file_map_close(&banks[i].map);
+        banks[i].clips = 0;
+    }
+}
+
+// Starts loading one entry. Returns an error to raise, or Qnil.
+static VALUE load_bank_entry(int bank, const bank_entry *entry, VALUE name, int *pClipId)
+{
+    char vfs_name[MEMORY_VFS_NAME_CAP];
+
+    if (clip_registry_full()) {
+        return rb_exc_new_str(rb_eRuntimeError, rb_sprintf("Too many clips loaded (max %d)", MAX_SOUNDS));
+    }
+
+    int index = memory_vfs_add(entry->pData, entry->size, entry->format, vfs_name, sizeof(vfs_name));
+    if (index < 0) {
+        return rb_exc_new_str(rb_eRuntimeError,
+                              rb_sprintf("Too many clips loaded from memory (max %d)", MEMORY_VFS_MAX_FILES));
+    }
+
+    ma_result result = load_clip_async(vfs_name, pClipId);
+    if (result != MA_SUCCESS) {
+        memory_vfs_remove(index);
+        return rb_exc_new_str(rb_eRuntimeError, rb_sprintf("Failed to load %"PRIsVALUE" from sound bank", name));
+    }
+
+    memory_files[*pClipId] = index;
+    clip_banks[*pClipId] = bank;
+    banks[bank].clips++;
+    return Qnil;
+}
+
+// Audio.load_bank(path) - loads every clip in a bank written by
+// NativeAudio::Bank. The file is opened and mapped once; each entry
+// decodes from the mapping on the job threads, all queued before any is
+// waited on, and playable WAVs aren't decoded at all. Returns a Hash of
+// name => clip ID. If any entry fails, none stay loaded.
+VALUE audio_load_bank(VALUE self, VALUE file)
+{
+    const char *path = StringValueCStr(file);
+
+    unload_collected_clips();
+
+    int bank = 0;
+    while (bank < MAX_BANKS && banks[bank].map.pData != NULL) {
+        bank++;
+    }
+    if (bank == MAX_BANKS) {
+        rb_raise(rb_eRuntimeError, "Too many sound banks loaded (max %d)", MAX_BANKS);
+        return Qnil;
+    }
+
+    ma_uint32 count = 0;
+    ma_result result = bank_open(path, &banks[bank].map, &count);
+    if (result == MA_INVALID_FILE) {
+        rb_raise(rb_eRuntimeError, "Not a sound bank: %s", path);
+        return Qnil;
+    }
+    if (result != MA_SUCCESS) {
+        rb_raise(rb_eRuntimeError, "Failed to open sound bank: %s", path);
+        return Qnil;
+    }
+
+    // Errors are held until every clip started is unloaded again
+    banks[bank].clips = 1;
+    VALUE clips = rb_hash_new();
+    VALUE names = rb_ary_new_capa(count);
+    VALUE error = Qnil;
+
+    for (ma_uint32 i = 0; i < count && NIL_P(error); i++) {
+        bank_entry entry;
+        bank_get_entry(&banks[bank].map, i, &entry);
+
+        VALUE name = rb_utf8_str_new(entry.name, (long)entry.name_length);
+        if (!NIL_P(rb_hash_lookup(clips, name))) {
+            continue;
+        }
+
+        int clip_id;
+        error = load_bank_entry(bank, &entry, name, &clip_id);
+        if (NIL_P(error)) {
+            rb_hash_aset(clips, name, INT2NUM(clip_id));
+            rb_ary_push(names, name);
+        }
+    }
+
+    for (long i = 0; i < RARRAY_LEN(names) && NIL_P(error); i++) {
+        VALUE name = rb_ary_entry(names, i);
+        if (!settle_load(NUM2INT(rb_hash_aref(clips, name)))) {
+            rb_hash_delete(clips, name);
+            error = rb_exc_new_str(rb_eRuntimeError, rb_sprintf("Failed to load %"PRIsVALUE" from sound bank", name));
+        }
+    }
+
+    if (!NIL_P(error)) {
+        for (long i = 0; i < RARRAY_LEN(names); i++) {
+            VALUE clip = rb_hash_lookup(clips, rb_ary_entry(names, i));
+            if (!NIL_P(clip)) {
+                disown_clip(NUM2INT(clip), 1);
+            }
+        }
+    }
+
+    release_bank(bank);
+
+    if (!NIL_P(error)) {
+        rb_exc_raise(error);
+        return Qnil;
+    }
+
+    enforce_budget();
+    return clips;
+}
+
+// ============================================================================
+// Playback Controls
+// ============================================================================
+
+// Drain deadline for a channel that just went quiet: the chain's analytical
+// tail length, capped at REVERB_DRAIN_SECONDS. Dry voices drain instantly.
+static ma_uint64 drain_deadline(int channel, ma_uint64 now)
+{
+    ma_uint64 cap = (ma_uint64)(REVERB_DRAIN_SECONDS * ma_engine_get_sample_rate(&engine));
+    voice *v = voice_pool_peek(channel);
+    ma_uint64 tail = (v != NULL) ? voice_tail_frames(v) : 0;
+
+    return now + (tail < cap ? tail : cap);
+}
+
+// Phase 1: sound finished - release the channel, start drain timer
+static void release_finished_channel(int channel, ma_uint64 now)
+{
+    if (channels[channel] == NULL || !ma_sound_at_end(channels[channel]) || ma_sound_is_looping(channels[channel])) {
+        return;
+    }
+
+    channels[channel] = NULL;
+    channel_alloc_start_drain(channel, drain_deadline(channel, now));
+
+    if (channel_freed_callback != Qnil) {
+        rb_funcall(channel_freed_callback, rb_intern("call"), 1, INT2NUM(channel));
+    }
+}
+
+// Channels given a stop time. The sound goes quiet on its own at that frame
+// but raises no end event, so each cleanup pass checks the list.
+static int scheduled_stops[MAX_CHANNELS];
+static int scheduled_stop_count = 0;
+
+static void unschedule_stop(int channel)
+{
+    for (int i = 0; i < scheduled_stop_count; i++) {
+        if (scheduled_stops[i] == channel) {
+            scheduled_stops[i] = scheduled_stops[--scheduled_stop_count];
+            return;
+        }
+    }
+}
+
+static void schedule_stop(int channel, ma_uint64 frame)
+{
+    unschedule_stop(channel);
+    ma_sound_set_stop_time_in_pcm_frames(channels[channel], frame);
+    scheduled_stops[scheduled_stop_count++] = channel;
+}
+
+// Releases channels whose stop time has passed, draining from that frame
+static void release_stopped_channels(ma_uint64 now)
+{
+    int stopped[MAX_CHANNELS];
+    int stopped_count = 0;
+
+    for (int i = 0; i < scheduled_stop_count; ) {
+        int channel = scheduled_stops[i];
+        ma_sound *sound = channels[channel];
+
+        if (sound != NULL && ma_node_get_state_time(sound, ma_node_state_stopped) > now) {
+            i++;
+            continue;
+        }
+
+        scheduled_stops[i] = scheduled_stops[--scheduled_stop_count];
+        if (sound != NULL) {
+            stopped[stopped_count++] = channel;
+        }
+    }
+
+    // The callback may play again, so the list is settled before it runs
+    for (int i = 0; i < stopped_count; i++) {
+        int channel = stopped[i];
+        ma_uint64 stop_frame = ma_node_get_state_time(channels[channel], ma_node_state_stopped);
+
+        ma_sound_stop(channels[channel]);
+        channels[channel] = NULL;
+        channel_alloc_start_drain(channel, drain_deadline(channel, stop_frame));
+
+        if (channel_freed_callback != Qnil) {
+            rb_funcall(channel_freed_callback, rb_intern("call"), 1, INT2NUM(channel));
+        }
+    }
+}
+
+// Pulls the deadline in to now for draining channels whose effects report
+// silence, so they're reclaimed by the pass below
+static void reclaim_silent_tails(ma_uint64 now)
+{
+    int silent[MAX_CHANNELS];
+    int silent_count = 0;
+    int draining = channel_alloc_draining_count();
+
+    for (int i = 0; i < draining; i++) {
+        int channel = channel_alloc_draining_at(i);
+        voice *v = voice_pool_peek(channel);
+
+        if (channel_alloc_drain_deadline(channel) > now && (v == NULL || voice_tail_is_silent(v))) {
+            silent[silent_count++] = channel;
+        }
+    }
+
+    for (int i = 0; i < silent_count; i++) {
+        channel_alloc_start_drain(silent[i], now);
+    }
+}
+
+static void cleanup_finished_channels(int skip_channel)
+{
+    ma_uint64 now = ma_engine_get_time_in_pcm_frames(&engine);
+    int channel;
+
+    // End events are pushed by the audio thread, so only channels that
+    // actually finished are visited
+    while (voice_pool_pop_finished(&channel)) {
+        if (channel != skip_channel) {
+            release_finished_channel(channel, now);
+        }
+    }
+
+    // If the queue ever filled up, fall back to checking every channel
+    if (voice_pool_finished_overflowed()) {
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            if (i != skip_channel) {
+                release_finished_channel(i, now);
+            }
+        }
+    }
+
+    release_stopped_channels(now);
+
+    // Removed delays and reverbs that have rung out leave the chain
+    voice_pool_route_lingering();
+
+    // Tails that have already decayed don't wait out their deadline
+    reclaim_silent_tails(now);
+
+    // Phase 2: drain timer expired - take the voice out of the graph.
+    // Draining channels come off a heap in deadline order.
+    while (channel_alloc_pop_expired(now, &channel)) {
+        voice *v = voice_pool_peek(channel);
+        voice_detach(v);
+        voice_drop_retired_clip(v);
+    }
+}
+
+// Cuts the tail of the draining channel nearest its deadline, handing its
+// effect nodes back to the pools. False if nothing is draining.
+static ma_bool32 reclaim_draining_voice(void)
+{
+    if (channel_alloc_draining_count() == 0) {
+        return MA_FALSE;
+    }
+
+    int channel = channel_alloc_draining_at(0);
+    voice *v = voice_pool_peek(channel);
+
+    channel_alloc_release(channel);
+    voice_detach(v);
+    voice_drop_retired_clip(v);
+
+    return MA_TRUE;
+}
+
+// Borrows an effect node for a live voice. The pools are filled at init,
+// so when one is empty draining tails are cut short to refill it.
+static void ensure_effect(voice *v, ma_result (*ensure)(voice *), const char *kind)
+{
+    while (ensure(v) != MA_SUCCESS) {
+        if (!reclaim_draining_voice()) {
+            rb_raise(rb_eRuntimeError, "All %s nodes are in use (Audio.init effects: sets how many)", kind);
+        }
+    }
+}
+
+// Loads the clip into the channel's voice and routes it, ready to start.
+// Whatever the channel was playing is cut.
+static voice *prepare_voice(int channel, int clip_id)
+{
+    if (!clip_id_valid(clip_id)) {
+        rb_raise(rb_eArgError, "Invalid clip ID: %d", clip_id);
+        return NULL;
+    }
+
+    if (channel < 0 || channel >= voice_pool_size()) {
+        rb_raise(rb_eArgError, "Invalid channel ID: %d", channel);
+        return NULL;
+    }
+
+    // A first load has to finish so its errors surface here. An evicted
+    // clip decoded fine before, so it plays from the pages decoded so far.
+    if (pending_loads[clip_id] != NULL && !pending_loads[clip_id]->reload) {
+        wait_for_load(clip_id);
+    }
+    unload_collected_clips();
+    reload_clip(clip_id);
+    clip_registry_touch(clip_id);
+
+    cleanup_finished_channels(channel);
+
+    // Cancel any pending drain timer for this channel
+    channel_alloc_mark_playing(channel);
+
+    voice *v = voice_pool_peek(channel);
+
+    // Cut whatever is still playing or draining on this channel
+    voice_detach(v);
+    channels[channel] = NULL;
+    unschedule_stop(channel);
+
+    // The voice holds a reference to whichever clip its sound copies
+    int previous_clip = v->clip_id;
+    ma_result result = voice_load_clip(v, sounds[clip_id], clip_streamed[clip_id] ? clip_paths[clip_id] : NULL,
+                                       clip_id, clip_engine_format[clip_id]);
+    if (previous_clip != v->clip_id) {
+        if (previous_clip >= 0) clip_release(previous_clip);
+        if (v->clip_id >= 0) clip_registry_retain(v->clip_id);
+    }
+    if (result != MA_SUCCESS) {
+        rb_raise(rb_eRuntimeError, "Failed to create sound copy for playback");
+        return NULL;
+    }
+
+    // Route: sound -> endpoint, effects are spliced in when first used
+    voice_attach(v);
+
+    return v;
+}
+
+static void start_voice(int channel, voice *v)
+{
+    channels[channel] = &v->sound;
+    ma_sound_start(&v->sound);
+
+    // A reload may have pushed the total over budget
+    enforce_budget();
+}
+
+VALUE audio_play(VALUE self, VALUE channel_id, VALUE clip)
+{
+    int channel = NUM2INT(channel_id);
+    voice *v = prepare_voice(channel, NUM2INT(clip));
+
+    start_voice(channel, v);
+
+    return rb_int2inum(channel);
+}
+
+VALUE audio_stop(VALUE self, VALUE channel_id)
+{
+    int channel = NUM2INT(channel_id);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    ma_uint64 now = ma_engine_get_time_in_pcm_frames(&engine);
+
+    ma_sound_stop(channels[channel]);
+    channels[channel] = NULL;
+    unschedule_stop(channel);
+
+    channel_alloc_start_drain(channel, drain_deadline(channel, now));
+
+    return Qnil;
+}
+
+VALUE audio_pause(VALUE self, VALUE channel_id)
+{
+    int channel = NUM2INT(channel_id);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    ma_sound_stop(channels[channel]);
+
+    return Qnil;
+}
+
+VALUE audio_resume(VALUE self, VALUE channel_id)
+{
+    int channel = NUM2INT(channel_id);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    ma_sound_start(channels[channel]);
+
+    return Qnil;
+}
+
+// ============================================================================
+// Scheduled Playback
+// ============================================================================
+
+// Frames are engine time: the count of frames the engine has output (or
+// rendered offline) since init. The graph starts and stops sounds on
+// the exact frame, even partway through a block, so sounds queued ahead
+// aren't held to when the Ruby thread gets to run.
+
+// Audio.time_in_frames
+VALUE audio_time_in_frames(VALUE self)
+{
+    if (!engine_initialized) {
+        return INT2NUM(0);
+    }
+
+    return ULL2NUM(ma_engine_get_time_in_pcm_frames(&engine));
+}
+
+// Audio.play_at(channel, clip, frame) - plays the clip from that engine
+// frame. The channel counts as playing from now; a frame already past
+// starts it straight away.
+VALUE audio_play_at(VALUE self, VALUE channel_id, VALUE clip, VALUE frame)
+{
+    int channel = NUM2INT(channel_id);
+    ma_uint64 start = NUM2ULL(frame);
+    voice *v = prepare_voice(channel, NUM2INT(clip));
+
+    ma_sound_set_start_time_in_pcm_frames(&v->sound, start);
+    start_voice(channel, v);
+
+    return rb_int2inum(channel);
+}
+
+// Audio.stop_at(channel, frame) - stops the channel at that engine frame.
+// It's released (and on_channel_freed called) by the first cleanup after.
+VALUE audio_stop_at(VALUE self, VALUE channel_id, VALUE frame)
+{
+    int channel = NUM2INT(channel_id);
+    ma_uint64 stop = NUM2ULL(frame);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    schedule_stop(channel, stop);
+
+    return Qnil;
+}
+
+// ============================================================================
+// Sound Effects
+// ============================================================================
+
+VALUE audio_set_volume(VALUE self, VALUE channel_id, VALUE volume)
+{
+    int channel = NUM2INT(channel_id);
+    int vol = NUM2INT(volume);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    voice_set_volume(voice_pool_peek(channel), vol / 128.0f);
+
+    return Qnil;
+}
+
+// Pitching an engine-format voice makes its copy again. Should that fail
+// the voice has lost its sound, so the channel is let go before raising.
+static void set_voice_pitch(voice *v, float pitch)
+{
+    int clip_id = v->clip_id;
+    if (voice_set_pitch(v, pitch) == MA_SUCCESS) {
+        return;
+    }
+
+    if (v->clip_id < 0) {
+        channels[v->channel] = NULL;
+        unschedule_stop(v->channel);
+        voice_detach(v);
+        channel_alloc_release(v->channel);
+        clip_release(clip_id);
+    }
+    rb_raise(rb_eRuntimeError, "Failed to create sound copy for pitched playback");
+}
+
+VALUE audio_set_pitch(VALUE self, VALUE channel_id, VALUE pitch)
+{
+    int channel = NUM2INT(channel_id);
+    float p = (float)NUM2DBL(pitch);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    set_voice_pitch(voice_pool_peek(channel), p);
+
+    return Qnil;
+}
+
+// Angle in degrees clockwise from straight ahead, distance 0-255
+static void set_sound_position(ma_sound *sound, int angle, int distance)
+{
+    float rad = angle * (MA_PI / 180.0f);
+    float normalized_dist = distance / 255.0f;
+    float x = normalized_dist * sinf(rad);
+    float z = -normalized_dist * cosf(rad);
 
-    return Qnil;
+    ma_sound_set_position(sound, x, 0.0f, z);
 }
 
 VALUE audio_set_pos(VALUE self, VALUE channel_id, VALUE angle, VALUE distance)
@@ -421,12 +2276,7 @@ VALUE audio_set_pos(VALUE self, VALUE channel_id, VALUE angle, VALUE distance)
         return Qnil;
     }
 
-    float rad = ang * (MA_PI / 180.0f);
-    float normalized_dist = dist / 255.0f;
-    float x = normalized_dist * sinf(rad);
-    float z = -normalized_dist * cosf(rad);
-
-    ma_sound_set_position(channels[channel], x, 0.0f, z);
+    set_sound_position(channels[channel], ang, dist);
 
     return Qnil;
 }
@@ -440,7 +2290,7 @@ VALUE audio_set_pan(VALUE self, VALUE channel_id, VALUE pan)
         return Qnil;
     }
 
-    ma_sound_set_pan(channels[channel], p);
+    voice_set_pan(voice_pool_peek(channel), p);
 
     return Qnil;
 }
@@ -477,24 +2327,49 @@ VALUE audio_set_looping(VALUE self, VALUE channel_id, VALUE looping)
 // Delay Tap Controls
 // ============================================================================
 
-VALUE audio_add_delay_tap(VALUE self, VALUE channel_id, VALUE time_ms, VALUE volume)
+// Returns the channel's voice while it is playing or draining, NULL otherwise
+static voice *live_voice(int channel)
 {
-    int channel = NUM2INT(channel_id);
-    float ms = (float)NUM2DBL(time_ms);
-    float vol = (float)NUM2DBL(volume);
+    if (channel < 0 || channel >= MAX_CHANNELS) {
+        return NULL;
+    }
 
-    if (channel < 0 || channel >= MAX_CHANNELS || delay_nodes[channel] == NULL) {
-        rb_raise(rb_eArgError, "Invalid channel or no delay node: %d", channel);
-        return Qnil;
+    voice *v = voice_pool_peek(channel);
+    if (v == NULL || !v->attached) {
+        return NULL;
     }
 
-    int tap_id = multi_tap_delay_add_tap(delay_nodes[channel], ms, vol);
+    return v;
+}
+
+static int add_voice_delay_tap(voice *v, float ms, float vol)
+{
+    ensure_effect(v, voice_ensure_delay, "delay");
+
+    int tap_id = multi_tap_delay_add_tap(v->delay, ms, vol);
     if (tap_id < 0) {
         rb_raise(rb_eRuntimeError, "Failed to add delay tap (max taps reached)");
+        return -1;
+    }
+
+    voice_route(v);
+
+    return tap_id;
+}
+
+VALUE audio_add_delay_tap(VALUE self, VALUE channel_id, VALUE time_ms, VALUE volume)
+{
+    int channel = NUM2INT(channel_id);
+    float ms = (float)NUM2DBL(time_ms);
+    float vol = (float)NUM2DBL(volume);
+
+    voice *v = live_voice(channel);
+    if (v == NULL) {
+        rb_raise(rb_eArgError, "Invalid channel or channel not playing: %d", channel);
         return Qnil;
     }
 
-    return rb_int2inum(tap_id);
+    return rb_int2inum(add_voice_delay_tap(v, ms, vol));
 }
 
 VALUE audio_remove_delay_tap(VALUE self, VALUE channel_id, VALUE tap_id)
@@ -502,11 +2377,13 @@ VALUE audio_remove_delay_tap(VALUE self, VALUE channel_id, VALUE tap_id)
     int channel = NUM2INT(channel_id);
     int tap = NUM2INT(tap_id);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || delay_nodes[channel] == NULL) {
+    voice *v = live_voice(channel);
+    if (v == NULL || v->delay == NULL) {
         return Qnil;
     }
 
-    multi_tap_delay_remove_tap(delay_nodes[channel], tap);
+    multi_tap_delay_remove_tap(v->delay, tap);
+    voice_route(v);
 
     return Qnil;
 }
@@ -517,11 +2394,12 @@ VALUE audio_set_delay_tap_volume(VALUE self, VALUE channel_id, VALUE tap_id, VAL
     int tap = NUM2INT(tap_id);
     float vol = (float)NUM2DBL(volume);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || delay_nodes[channel] == NULL) {
+    voice *v = live_voice(channel);
+    if (v == NULL || v->delay == NULL) {
         return Qnil;
     }
 
-    multi_tap_delay_set_volume(delay_nodes[channel], tap, vol);
+    multi_tap_delay_set_volume(v->delay, tap, vol);
 
     return Qnil;
 }
@@ -532,11 +2410,12 @@ VALUE audio_set_delay_tap_time(VALUE self, VALUE channel_id, VALUE tap_id, VALUE
     int tap = NUM2INT(tap_id);
     float ms = (float)NUM2DBL(time_ms);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || delay_nodes[channel] == NULL) {
+    voice *v = live_voice(channel);
+    if (v == NULL || v->delay == NULL) {
         return Qnil;
     }
 
-    multi_tap_delay_set_time(delay_nodes[channel], tap, ms);
+    multi_tap_delay_set_time(v->delay, tap, ms);
 
     return Qnil;
 }
@@ -545,16 +2424,41 @@ VALUE audio_set_delay_tap_time(VALUE self, VALUE channel_id, VALUE tap_id, VALUE
 // Reverb Controls
 // ============================================================================
 
+// Returns the channel's reverb node, borrowing one from the pool if needed.
+// The node only joins the chain once it is enabled.
+static reverb_node *channel_reverb(int channel)
+{
+    voice *v = live_voice(channel);
+    if (v == NULL) {
+        return NULL;
+    }
+
+    ensure_effect(v, voice_ensure_reverb, "reverb");
+    return v->reverb;
+}
+
+static void set_voice_reverb_enabled(voice *v, ma_bool32 enabled)
+{
+    if (!enabled && v->reverb == NULL) {
+        return;
+    }
+
+    ensure_effect(v, voice_ensure_reverb, "reverb");
+    reverb_set_enabled(v->reverb, enabled);
+    voice_route(v);
+}
+
 VALUE audio_enable_reverb(VALUE self, VALUE channel_id, VALUE enabled)
 {
     int channel = NUM2INT(channel_id);
     ma_bool32 en = RTEST(enabled) ? MA_TRUE : MA_FALSE;
 
-    if (channel < 0 || channel >= MAX_CHANNELS || reverb_nodes[channel] == NULL) {
+    voice *v = live_voice(channel);
+    if (v == NULL) {
         return Qnil;
     }
 
-    reverb_set_enabled(reverb_nodes[channel], en);
+    set_voice_reverb_enabled(v, en);
     return Qnil;
 }
 
@@ -563,11 +2467,12 @@ VALUE audio_set_reverb_room_size(VALUE self, VALUE channel_id, VALUE size)
     int channel = NUM2INT(channel_id);
     float s = (float)NUM2DBL(size);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || reverb_nodes[channel] == NULL) {
+    reverb_node *reverb = channel_reverb(channel);
+    if (reverb == NULL) {
         return Qnil;
     }
 
-    reverb_set_room_size(reverb_nodes[channel], s);
+    reverb_set_room_size(reverb, s);
     return Qnil;
 }
 
@@ -576,11 +2481,12 @@ VALUE audio_set_reverb_damping(VALUE self, VALUE channel_id, VALUE damp)
     int channel = NUM2INT(channel_id);
     float d = (float)NUM2DBL(damp);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || reverb_nodes[channel] == NULL) {
+    reverb_node *reverb = channel_reverb(channel);
+    if (reverb == NULL) {
         return Qnil;
     }
 
-    reverb_set_damping(reverb_nodes[channel], d);
+    reverb_set_damping(reverb, d);
     return Qnil;
 }
 
@@ -589,11 +2495,12 @@ VALUE audio_set_reverb_wet(VALUE self, VALUE channel_id, VALUE wet)
     int channel = NUM2INT(channel_id);
     float w = (float)NUM2DBL(wet);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || reverb_nodes[channel] == NULL) {
+    reverb_node *reverb = channel_reverb(channel);
+    if (reverb == NULL) {
         return Qnil;
     }
 
-    reverb_set_wet(reverb_nodes[channel], w);
+    reverb_set_wet(reverb, w);
     return Qnil;
 }
 
@@ -602,63 +2509,372 @@ VALUE audio_set_reverb_dry(VALUE self, VALUE channel_id, VALUE dry)
     int channel = NUM2INT(channel_id);
     float d = (float)NUM2DBL(dry);
 
-    if (channel < 0 || channel >= MAX_CHANNELS || reverb_nodes[channel] == NULL) {
+    reverb_node *reverb = channel_reverb(channel);
+    if (reverb == NULL) {
         return Qnil;
     }
 
-    reverb_set_dry(reverb_nodes[channel], d);
+    reverb_set_dry(reverb, d);
     return Qnil;
 }
 
 // ============================================================================
-// Channel Query
+// Reverb Buses
 // ============================================================================
 
-VALUE audio_next_free_channel(VALUE self)
+VALUE audio_create_reverb_bus(VALUE self)
 {
-    cleanup_finished_channels(-1);
+    int bus = reverb_bus_create(&engine);
+    if (bus < 0) {
+        rb_raise(rb_eRuntimeError, "Failed to create reverb bus (max %d)", MAX_REVERB_BUSES);
+        return Qnil;
+    }
 
-    // Prefer fully drained channels to preserve reverb tails
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (channels[i] == NULL && drain_until_frame[i] == 0) {
-            return rb_int2inum(i);
-        }
+    return rb_int2inum(bus);
+}
+
+VALUE audio_set_reverb_bus(VALUE self, VALUE bus_id, VALUE size, VALUE damp, VALUE wet)
+{
+    int bus = NUM2INT(bus_id);
+    reverb_node *reverb = reverb_bus_get(bus);
+
+    if (reverb == NULL) {
+        rb_raise(rb_eArgError, "Invalid reverb bus: %d", bus);
+        return Qnil;
     }
 
-    // Fall back to draining channels if all else is exhausted
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (channels[i] == NULL) {
-            return rb_int2inum(i);
-        }
+    reverb_set_room_size(reverb, (float)NUM2DBL(size));
+    reverb_set_damping(reverb, (float)NUM2DBL(damp));
+    reverb_set_wet(reverb, (float)NUM2DBL(wet));
+    return Qnil;
+}
+
+static void check_reverb_bus(int bus)
+{
+    if (reverb_bus_get(bus) == NULL) {
+        rb_raise(rb_eArgError, "Invalid reverb bus: %d", bus);
     }
+}
 
-    return rb_int2inum(-1);
+static void set_voice_send(voice *v, int bus, float level)
+{
+    ensure_effect(v, voice_ensure_send, "send");
+    voice_set_send(v, bus, level);
 }
 
-VALUE audio_reset_all_channels(VALUE self)
+VALUE audio_set_reverb_send(VALUE self, VALUE channel_id, VALUE bus_id, VALUE level)
 {
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        if (channels[i] != NULL) {
-            ma_sound_stop(channels[i]);
-            ma_sound_uninit(channels[i]);
-            free(channels[i]);
-            channels[i] = NULL;
-        }
+    int channel = NUM2INT(channel_id);
+    int bus = NUM2INT(bus_id);
+    float l = (float)NUM2DBL(level);
+
+    check_reverb_bus(bus);
+
+    voice *v = live_voice(channel);
+    if (v == NULL) {
+        return Qnil;
+    }
+
+    set_voice_send(v, bus, l);
+    return Qnil;
+}
+
+// ============================================================================
+// Parameter Ramps
+// ============================================================================
+
+// Ramps run on the audio thread, one step per sample, starting at the top
+// of the next block. A new ramp heads off from wherever the last one got
+// to. :exponential moves at a constant rate in dB, from or to -80 dB
+// where the level is 0; pan ramps are always linear.
+
+static VALUE sym_linear, sym_exponential;
+
+static ramp_curve ramp_curve_from(VALUE curve)
+{
+    if (NIL_P(curve) || curve == sym_linear) {
+        return RAMP_LINEAR;
+    }
+    if (curve == sym_exponential) {
+        return RAMP_EXPONENTIAL;
+    }
+
+    rb_raise(rb_eArgError, "Unknown ramp curve: %"PRIsVALUE, rb_inspect(curve));
+    return RAMP_LINEAR;
+}
+
+static ma_uint32 ramp_frames_from(VALUE time_ms)
+{
+    double ms = NUM2DBL(time_ms);
+    if (ms < 0.0) {
+        rb_raise(rb_eArgError, "Ramp length must not be negative: %f", ms);
+        return 0;
+    }
+
+    double frames = ms * ma_engine_get_sample_rate(&engine) / 1000.0 + 0.5;
+    return (frames >= 4294967295.0) ? 0xFFFFFFFF : (ma_uint32)frames;
+}
+
+// Returns the playing channel's voice with a fade node, or NULL if the
+// channel isn't playing
+static voice *fading_voice(int channel)
+{
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return NULL;
+    }
+
+    voice *v = voice_pool_peek(channel);
+    ensure_effect(v, voice_ensure_fade, "fade");
+
+    return v;
+}
+
+// Audio.fade_volume(channel, volume, time_ms, curve = :linear) - volume
+// is 0-128, as for set_volume
+VALUE audio_fade_volume(int argc, VALUE *argv, VALUE self)
+{
+    VALUE channel_id, volume, time_ms, curve;
+    rb_scan_args(argc, argv, "31", &channel_id, &volume, &time_ms, &curve);
+
+    int channel = NUM2INT(channel_id);
+    int vol = NUM2INT(volume);
+    ma_uint32 frames = ramp_frames_from(time_ms);
+    ramp_curve c = ramp_curve_from(curve);
+
+    voice *v = fading_voice(channel);
+    if (v == NULL) {
+        return Qnil;
+    }
+
+    fade_ramp_volume(v->fade, vol / 128.0f, frames, c);
+    return Qnil;
+}
+
+VALUE audio_ramp_pan(VALUE self, VALUE channel_id, VALUE pan, VALUE time_ms)
+{
+    int channel = NUM2INT(channel_id);
+    float p = (float)NUM2DBL(pan);
+    ma_uint32 frames = ramp_frames_from(time_ms);
+
+    voice *v = fading_voice(channel);
+    if (v == NULL) {
+        return Qnil;
+    }
+
+    fade_ramp_pan(v->fade, p, frames);
+    return Qnil;
+}
+
+// Audio.ramp_reverb_wet(channel, wet, time_ms, curve = :linear)
+VALUE audio_ramp_reverb_wet(int argc, VALUE *argv, VALUE self)
+{
+    VALUE channel_id, wet, time_ms, curve;
+    rb_scan_args(argc, argv, "31", &channel_id, &wet, &time_ms, &curve);
+
+    int channel = NUM2INT(channel_id);
+    float w = (float)NUM2DBL(wet);
+    ma_uint32 frames = ramp_frames_from(time_ms);
+    ramp_curve c = ramp_curve_from(curve);
+
+    reverb_node *reverb = channel_reverb(channel);
+    if (reverb == NULL) {
+        return Qnil;
+    }
+
+    reverb_ramp_wet(reverb, w, frames, c);
+    return Qnil;
+}
+
+// Audio.ramp_reverb_dry(channel, dry, time_ms, curve = :linear)
+VALUE audio_ramp_reverb_dry(int argc, VALUE *argv, VALUE self)
+{
+    VALUE channel_id, dry, time_ms, curve;
+    rb_scan_args(argc, argv, "31", &channel_id, &dry, &time_ms, &curve);
 
-        if (delay_nodes[i] != NULL) {
-            multi_tap_delay_uninit(delay_nodes[i]);
-            free(delay_nodes[i]);
-            delay_nodes[i] = NULL;
+    int channel = NUM2INT(channel_id);
+    float d = (float)NUM2DBL(dry);
+    ma_uint32 frames = ramp_frames_from(time_ms);
+    ramp_curve c = ramp_curve_from(curve);
+
+    reverb_node *reverb = channel_reverb(channel);
+    if (reverb == NULL) {
+        return Qnil;
+    }
+
+    reverb_ramp_dry(reverb, d, frames, c);
+    return Qnil;
+}
+
+// ============================================================================
+// Batched Parameters
+// ============================================================================
+
+// Every parameter of a source in one call, instead of a call per setter
+// that each looks the channel up again. play_with sets them before the
+// sound starts, so its first block already plays with them. Keys are
+// applied in the Hash's order:
+//
+//   volume: 0-128                 pitch: Float        looping: Boolean
+//   pan: -1.0..1.0                pos: [angle, distance]
+//   reverb: { room_size:, damping:, wet:, dry: }  (also enables reverb)
+//   reverb_enabled: Boolean       reverb_send: [bus, level]
+//   delay_taps: [[time_ms, volume], ...]
+//   start_at: engine frame        (play_with only; see play_at)
+
+static VALUE sym_volume, sym_pitch, sym_looping, sym_pan, sym_pos;
+static VALUE sym_reverb, sym_reverb_enabled, sym_reverb_send, sym_delay_taps, sym_start_at;
+static VALUE sym_room_size, sym_damping, sym_wet, sym_dry;
+
+typedef struct {
+    voice *v;
+    VALUE params;
+    VALUE tap_ids;      // IDs of the delay taps added, in order
+} param_target;
+
+static void apply_reverb(voice *v, VALUE settings)
+{
+    Check_Type(settings, T_HASH);
+
+    set_voice_reverb_enabled(v, MA_TRUE);
+    if (v->reverb == NULL) {
+        return;
+    }
+
+    VALUE value;
+    if ((value = rb_hash_lookup2(settings, sym_room_size, Qundef)) != Qundef) {
+        reverb_set_room_size(v->reverb, (float)NUM2DBL(value));
+    }
+    if ((value = rb_hash_lookup2(settings, sym_damping, Qundef)) != Qundef) {
+        reverb_set_damping(v->reverb, (float)NUM2DBL(value));
+    }
+    if ((value = rb_hash_lookup2(settings, sym_wet, Qundef)) != Qundef) {
+        reverb_set_wet(v->reverb, (float)NUM2DBL(value));
+    }
+    if ((value = rb_hash_lookup2(settings, sym_dry, Qundef)) != Qundef) {
+        reverb_set_dry(v->reverb, (float)NUM2DBL(value));
+    }
+}
+
+static int apply_param(VALUE key, VALUE value, VALUE arg)
+{
+    param_target *target = (param_target *)arg;
+    voice *v = target->v;
+
+    if (key == sym_volume) {
+        voice_set_volume(v, NUM2INT(value) / 128.0f);
+    } else if (key == sym_pitch) {
+        set_voice_pitch(v, (float)NUM2DBL(value));
+    } else if (key == sym_looping) {
+        ma_sound_set_looping(&v->sound, RTEST(value) ? MA_TRUE : MA_FALSE);
+    } else if (key == sym_pan) {
+        voice_set_pan(v, (float)NUM2DBL(value));
+    } else if (key == sym_pos) {
+        Check_Type(value, T_ARRAY);
+        set_sound_position(&v->sound, NUM2INT(rb_ary_entry(value, 0)), NUM2INT(rb_ary_entry(value, 1)));
+    } else if (key == sym_reverb) {
+        apply_reverb(v, value);
+    } else if (key == sym_reverb_enabled) {
+        set_voice_reverb_enabled(v, RTEST(value) ? MA_TRUE : MA_FALSE);
+    } else if (key == sym_reverb_send) {
+        Check_Type(value, T_ARRAY);
+        int bus = NUM2INT(rb_ary_entry(value, 0));
+        check_reverb_bus(bus);
+        set_voice_send(v, bus, (float)NUM2DBL(rb_ary_entry(value, 1)));
+    } else if (key == sym_delay_taps) {
+        Check_Type(value, T_ARRAY);
+        for (long i = 0; i < RARRAY_LEN(value); i++) {
+            VALUE tap = rb_ary_entry(value, i);
+            Check_Type(tap, T_ARRAY);
+            int tap_id = add_voice_delay_tap(v, (float)NUM2DBL(rb_ary_entry(tap, 0)),
+                                             (float)NUM2DBL(rb_ary_entry(tap, 1)));
+            rb_ary_push(target->tap_ids, INT2NUM(tap_id));
         }
+    } else if (key == sym_start_at) {
+        ma_sound_set_start_time_in_pcm_frames(&v->sound, NUM2ULL(value));
+    } else {
+        rb_raise(rb_eArgError, "Unknown playback parameter: %"PRIsVALUE, rb_inspect(key));
+    }
+
+    return ST_CONTINUE;
+}
+
+static VALUE apply_params(VALUE arg)
+{
+    param_target *target = (param_target *)arg;
+
+    target->tap_ids = rb_ary_new();
+    rb_hash_foreach(target->params, apply_param, (VALUE)target);
+
+    return target->tap_ids;
+}
 
-        if (reverb_nodes[i] != NULL) {
-            reverb_uninit(reverb_nodes[i]);
-            free(reverb_nodes[i]);
-            reverb_nodes[i] = NULL;
+// Audio.play_with(channel, clip, params) - plays the clip with params
+// already set. Returns the IDs of the delay taps added, in order.
+VALUE audio_play_with(VALUE self, VALUE channel_id, VALUE clip, VALUE params)
+{
+    int channel = NUM2INT(channel_id);
+    Check_Type(params, T_HASH);
+
+    voice *v = prepare_voice(channel, NUM2INT(clip));
+
+    // A bad parameter never starts the sound: the voice leaves the graph
+    // with whatever effects it took and the channel goes back to idle
+    int state = 0;
+    param_target target = { v, params, Qnil };
+    VALUE tap_ids = rb_protect(apply_params, (VALUE)&target, &state);
+
+    if (state != 0) {
+        voice_detach(v);
+        channel_alloc_release(channel);
+        rb_jump_tag(state);
+    }
+
+    start_voice(channel, v);
+
+    return tap_ids;
+}
+
+// Audio.apply(channel, params) - sets params on a playing channel. Does
+// nothing (and returns nil) if the channel isn't playing.
+VALUE audio_apply(VALUE self, VALUE channel_id, VALUE params)
+{
+    int channel = NUM2INT(channel_id);
+    Check_Type(params, T_HASH);
+
+    if (channel < 0 || channel >= MAX_CHANNELS || channels[channel] == NULL) {
+        return Qnil;
+    }
+
+    param_target target = { voice_pool_peek(channel), params, Qnil };
+    return apply_params((VALUE)&target);
+}
+
+// ============================================================================
+// Channel Query
+// ============================================================================
+
+VALUE audio_next_free_channel(VALUE self)
+{
+    cleanup_finished_channels(-1);
+
+    // Prefers fully drained channels to preserve reverb tails, then falls
+    // back to the draining channel closest to its deadline
+    return rb_int2inum(channel_alloc_next());
+}
+
+VALUE audio_reset_all_channels(VALUE self)
+{
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        voice *v = voice_pool_peek(i);
+        if (v != NULL) {
+            voice_detach(v);
+            voice_drop_retired_clip(v);
         }
 
-        drain_until_frame[i] = 0;
+        channels[i] = NULL;
     }
+    scheduled_stop_count = 0;
+    channel_alloc_reset();
 
     return Qnil;
 }
@@ -675,6 +2891,155 @@ VALUE audio_on_channel_freed(VALUE self, VALUE callback)
     return Qnil;
 }
 
+// ============================================================================
+// Offline Rendering
+// ============================================================================
+
+typedef struct {
+    ma_uint64 frame_count;
+    float *pOutput;         // Whole render, or NULL when streaming to the encoder
+    ma_encoder *pEncoder;
+    float *pScratch;        // One chunk, used with the encoder
+    ma_uint64 rendered;
+    ma_result result;
+    volatile ma_bool32 cancelled;  // Set by the unblock function on interrupt
+} render_job;
+
+// Pulls frames through the graph as fast as the CPU allows. Runs without
+// the GVL; the graph is already built for concurrent access from Ruby.
+static void *render_frames(void *pUserData)
+{
+    render_job *job = (render_job *)pUserData;
+    ma_uint32 numChannels = ma_engine_get_channels(&engine);
+    ma_uint64 start = ma_engine_get_time_in_pcm_frames(&engine);
+    ma_uint64 done = 0;
+
+    job->result = MA_SUCCESS;
+
+    while (done < job->frame_count) {
+        ma_uint64 chunk = job->frame_count - done;
+        if (chunk > RENDER_CHUNK_FRAMES) chunk = RENDER_CHUNK_FRAMES;
+
+        // Cancelled: the graph runs whole blocks, so first read out the rest
+        // of the one it's partway through. Left behind, it would hold back
+        // the first sound played after by the frames still to come out.
+        if (job->cancelled) {
+            ma_uint64 processed = ma_engine_get_time_in_pcm_frames(&engine) - start;
+            if (processed <= done) break;
+            if (chunk > processed - done) chunk = processed - done;
+        }
+
+        float *pFrames = (job->pOutput != NULL) ? job->pOutput + done * numChannels : job->pScratch;
+
+        job->result = ma_engine_read_pcm_frames(&engine, pFrames, chunk, NULL);
+        if (job->result != MA_SUCCESS) break;
+
+        if (job->pEncoder != NULL) {
+            job->result = ma_encoder_write_pcm_frames(job->pEncoder, pFrames, chunk, NULL);
+            if (job->result != MA_SUCCESS) break;
+        }
+
+        done += chunk;
+    }
+
+    job->rendered = done;
+    return NULL;
+}
+
+// Unblock function: Ctrl-C or Thread#kill stops the render at the next chunk
+static void cancel_render(void *pUserData)
+{
+    render_job *job = (render_job *)pUserData;
+    job->cancelled = MA_TRUE;
+}
+
+// Audio.render(seconds, path = nil) - renders the engine output without
+// waiting on a device. Writes a 32-bit float WAV and returns the frame
+// count when given a path, otherwise returns the interleaved f32 samples.
+// A running device is paused for the duration of the render.
+VALUE audio_render(int argc, VALUE *argv, VALUE self)
+{
+    VALUE seconds_value, path_value;
+    rb_scan_args(argc, argv, "11", &seconds_value, &path_value);
+
+    if (!engine_initialized) {
+        rb_raise(rb_eRuntimeError, "Audio engine is not initialized");
+        return Qnil;
+    }
+
+    double seconds = NUM2DBL(seconds_value);
+    if (seconds < 0.0) {
+        rb_raise(rb_eArgError, "Render length must not be negative: %f", seconds);
+        return Qnil;
+    }
+
+    ma_uint32 numChannels = ma_engine_get_channels(&engine);
+    ma_uint32 sample_rate = ma_engine_get_sample_rate(&engine);
+    render_job job;
+    ma_encoder encoder;
+    VALUE output = Qnil;
+
+    memset(&job, 0, sizeof(job));
+    job.frame_count = (ma_uint64)(seconds * sample_rate + 0.5);
+
+    if (!NIL_P(path_value)) {
+        const char *path = StringValueCStr(path_value);
+        ma_encoder_config encoder_config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, numChannels, sample_rate);
+
+        if (ma_encoder_init_file(path, &encoder_config, &encoder) != MA_SUCCESS) {
+            rb_raise(rb_eRuntimeError, "Failed to open render output: %s", path);
+            return Qnil;
+        }
+
+        job.pEncoder = &encoder;
+        job.pScratch = (float *)malloc(RENDER_CHUNK_FRAMES * numChannels * sizeof(float));
+        if (job.pScratch == NULL) {
+            ma_encoder_uninit(&encoder);
+            rb_raise(rb_eNoMemError, "Failed to allocate render buffer");
+            return Qnil;
+        }
+    } else {
+        // Rendered straight into the string that's returned
+        output = rb_str_new(NULL, (long)(job.frame_count * numChannels * sizeof(float)));
+        job.pOutput = (float *)RSTRING_PTR(output);
+    }
+
+    // The device thread would otherwise be pulling from the same graph
+    ma_device *pDevice = ma_engine_get_device(&engine);
+    ma_bool32 paused_device = pDevice != NULL && ma_device_is_started(pDevice);
+    if (paused_device) {
+        ma_engine_stop(&engine);
+    }
+
+    // Unlike the plain form, this one leaves an interrupt pending until the
+    // cleanup below is done. It skips the render if one is already pending.
+    rb_thread_call_without_gvl2(render_frames, &job, cancel_render, &job);
+
+    if (paused_device) {
+        ma_engine_start(&engine);
+    }
+
+    if (job.pEncoder != NULL) {
+        ma_encoder_uninit(&encoder);
+        free(job.pScratch);
+        output = ULL2NUM(job.frame_count);
+    }
+    RB_GC_GUARD(output);
+
+    if (job.result == MA_SUCCESS && job.rendered < job.frame_count) {
+        rb_thread_check_ints();
+        rb_raise(rb_eRuntimeError, "Render interrupted");
+        return Qnil;
+    }
+
+    if (job.result != MA_SUCCESS) {
+        rb_raise(rb_eRuntimeError, "Render failed: %s", ma_result_description(job.result));
+        return Qnil;
+    }
+
+    return output;
+}
+
 // ============================================================================
 // Ruby Module Setup
 // ============================================================================
@@ -682,21 +3047,71 @@ VALUE audio_on_channel_freed(VALUE self, VALUE callback)
 void Init_audio(void)
 {
     for (int i = 0; i < MAX_SOUNDS; i++) sounds[i] = NULL;
-    for (int i = 0; i < MAX_CHANNELS; i++) {
-        channels[i] = NULL;
-        delay_nodes[i] = NULL;
-        reverb_nodes[i] = NULL;
-        drain_until_frame[i] = 0;
-    }
+    for (int i = 0; i < MAX_SOUNDS; i++) pending_loads[i] = NULL;
+    for (int i = 0; i < MAX_SOUNDS; i++) clip_paths[i] = NULL;
+    for (int i = 0; i < MAX_SOUNDS; i++) memory_files[i] = -1;
+    for (int i = 0; i < MAX_SOUNDS; i++) clip_banks[i] = -1;
+    for (int i = 0; i < MEMORY_VFS_MAX_FILES; i++) memory_strings[i] = Qnil;
+    for (int i = 0; i < MAX_CHANNELS; i++) channels[i] = NULL;
+    channel_alloc_reset();
+    clip_registry_reset();
+    clip_index_reset();
+    simd_init();
+
+    sym_volume = ID2SYM(rb_intern("volume"));
+    sym_pitch = ID2SYM(rb_intern("pitch"));
+    sym_looping = ID2SYM(rb_intern("looping"));
+    sym_pan = ID2SYM(rb_intern("pan"));
+    sym_pos = ID2SYM(rb_intern("pos"));
+    sym_reverb = ID2SYM(rb_intern("reverb"));
+    sym_reverb_enabled = ID2SYM(rb_intern("reverb_enabled"));
+    sym_reverb_send = ID2SYM(rb_intern("reverb_send"));
+    sym_delay_taps = ID2SYM(rb_intern("delay_taps"));
+    sym_start_at = ID2SYM(rb_intern("start_at"));
+    sym_room_size = ID2SYM(rb_intern("room_size"));
+    sym_damping = ID2SYM(rb_intern("damping"));
+    sym_wet = ID2SYM(rb_intern("wet"));
+    sym_dry = ID2SYM(rb_intern("dry"));
+    sym_linear = ID2SYM(rb_intern("linear"));
+    sym_sample_rate = ID2SYM(rb_intern("sample_rate"));
+    sym_period_ms = ID2SYM(rb_intern("period_ms"));
+    sym_channels = ID2SYM(rb_intern("channels"));
+    sym_profile = ID2SYM(rb_intern("profile"));
+    sym_backend = ID2SYM(rb_intern("backend"));
+    sym_voices = ID2SYM(rb_intern("voices"));
+    sym_effects = ID2SYM(rb_intern("effects"));
+    sym_low_latency = ID2SYM(rb_intern("low_latency"));
+    sym_conservative = ID2SYM(rb_intern("conservative"));
+    sym_exponential = ID2SYM(rb_intern("exponential"));
 
     VALUE mAudio = rb_define_module("Audio");
 
+    cClipHandle = rb_define_class_under(mAudio, "ClipHandle", rb_cObject);
+    rb_undef_alloc_func(cClipHandle);
+
     // Initialization
-    rb_define_singleton_method(mAudio, "init", audio_init, 0);
+    rb_define_singleton_method(mAudio, "init", audio_init, -1);
+    rb_define_singleton_method(mAudio, "engine_info", audio_engine_info, 0);
+    rb_define_singleton_method(mAudio, "stop_device", audio_stop_device, 0);
+    rb_define_singleton_method(mAudio, "start_device", audio_start_device, 0);
 
     // Loading
-    rb_define_singleton_method(mAudio, "load", audio_load, 1);
+    rb_define_singleton_method(mAudio, "load", audio_load, -1);
     rb_define_singleton_method(mAudio, "duration", audio_duration, 1);
+    rb_define_singleton_method(mAudio, "load_async", audio_load_async, 1);
+    rb_define_singleton_method(mAudio, "loaded?", audio_loaded, 1);
+    rb_define_singleton_method(mAudio, "wait_load", audio_wait_load, 1);
+    rb_define_singleton_method(mAudio, "load_batch", audio_load_batch, 1);
+    rb_define_singleton_method(mAudio, "pcm_cache_dir=", audio_set_pcm_cache_dir, 1);
+    rb_define_singleton_method(mAudio, "pcm_cache_dir", audio_pcm_cache_dir, 0);
+    rb_define_singleton_method(mAudio, "load_memory", audio_load_memory, -1);
+    rb_define_singleton_method(mAudio, "load_memory_async", audio_load_memory_async, -1);
+    rb_define_singleton_method(mAudio, "load_bank", audio_load_bank, 1);
+    rb_define_singleton_method(mAudio, "unload", audio_unload, -1);
+    rb_define_singleton_method(mAudio, "clip_handle", audio_clip_handle, 1);
+    rb_define_singleton_method(mAudio, "clip_memory_budget=", audio_set_clip_memory_budget, 1);
+    rb_define_singleton_method(mAudio, "clip_memory_budget", audio_clip_memory_budget, 0);
+    rb_define_singleton_method(mAudio, "clip_memory_used", audio_clip_memory_used, 0);
 
     // Playback
     rb_define_singleton_method(mAudio, "play", audio_play, 2);
@@ -704,6 +3119,11 @@ void Init_audio(void)
     rb_define_singleton_method(mAudio, "pause", audio_pause, 1);
     rb_define_singleton_method(mAudio, "resume", audio_resume, 1);
 
+    // Scheduled playback
+    rb_define_singleton_method(mAudio, "time_in_frames", audio_time_in_frames, 0);
+    rb_define_singleton_method(mAudio, "play_at", audio_play_at, 3);
+    rb_define_singleton_method(mAudio, "stop_at", audio_stop_at, 2);
+
     // Effects
     rb_define_singleton_method(mAudio, "set_volume", audio_set_volume, 2);
     rb_define_singleton_method(mAudio, "set_pitch", audio_set_pitch, 2);
@@ -725,8 +3145,26 @@ void Init_audio(void)
     rb_define_singleton_method(mAudio, "set_reverb_wet", audio_set_reverb_wet, 2);
     rb_define_singleton_method(mAudio, "set_reverb_dry", audio_set_reverb_dry, 2);
 
+    // Reverb buses
+    rb_define_singleton_method(mAudio, "create_reverb_bus", audio_create_reverb_bus, 0);
+    rb_define_singleton_method(mAudio, "set_reverb_bus", audio_set_reverb_bus, 4);
+    rb_define_singleton_method(mAudio, "set_reverb_send", audio_set_reverb_send, 3);
+
+    // Ramps
+    rb_define_singleton_method(mAudio, "fade_volume", audio_fade_volume, -1);
+    rb_define_singleton_method(mAudio, "ramp_pan", audio_ramp_pan, 3);
+    rb_define_singleton_method(mAudio, "ramp_reverb_wet", audio_ramp_reverb_wet, -1);
+    rb_define_singleton_method(mAudio, "ramp_reverb_dry", audio_ramp_reverb_dry, -1);
+
+    // Batched parameters
+    rb_define_singleton_method(mAudio, "play_with", audio_play_with, 3);
+    rb_define_singleton_method(mAudio, "apply", audio_apply, 2);
+
     // Channel query
     rb_define_singleton_method(mAudio, "next_free_channel", audio_next_free_channel, 0);
     rb_define_singleton_method(mAudio, "on_channel_freed", audio_on_channel_freed, 1);
     rb_define_singleton_method(mAudio, "reset_all_channels", audio_reset_all_channels, 0);
+
+    // Offline rendering
+    rb_define_singleton_method(mAudio, "render", audio_render, -1);
 }
@@ -8,6 +8,14 @@
 #include "miniaudio.h"
 #include "delay_node.h"
 #include "reverb_node.h"
+#include "voice_pool.h"
+#include "channel_alloc.h"
+#include "memory_vfs.h"
+#include "clip_registry.h"
+#include "clip_index.h"
+#include "pcm_cache.h"
+#include "wav_map.h"
+#include "bank.h"
 
 // ============================================================================
 // Constants
@@ -15,7 +23,28 @@
 
 #define MAX_SOUNDS 1024
 #define MAX_CHANNELS 1024
-#define REVERB_DRAIN_SECONDS 3.0f
+#define OFFLINE_SAMPLE_RATE 48000
+#define OFFLINE_CHANNELS 2
+#define RENDER_CHUNK_FRAMES 4096
+#define DEFAULT_LOAD_THREADS 4
+#define MAX_LOAD_THREADS 64
+#define LOAD_WAIT_SLICE_MS 2  // How often a waiting thread checks for interrupts
+#define REGISTERED_NAME_CAP 48
+#define MAX_BANKS 64
+#define REVERB_DRAIN_SECONDS 3.0f  // Longest a stopped channel holds its effect tail
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// Bookkeeping for a clip still decoding on a job thread
+typedef struct {
+    ma_fence done;      // Released by the job thread when decoding ends
+    ma_mutex wait_lock; // Serializes waiters on the fence
+    int waiters;        // Ruby threads blocked in wait_load
+    ma_bool32 failed;   // Set by whichever waiter found the decode had failed
+    ma_bool32 reload;   // Decoding an evicted clip again
+} pending_load;
 
 // ============================================================================
 // Globals (defined in audio.c)
@@ -23,14 +52,16 @@
 
 extern ma_engine engine;
 extern ma_context context;
+extern ma_resource_manager resource_manager;
 extern ma_sound *sounds[MAX_SOUNDS];
+extern pending_load *pending_loads[MAX_SOUNDS];
+extern char *clip_paths[MAX_SOUNDS];       // Source file (or memory VFS name) of each clip
+extern ma_bool32 clip_streamed[MAX_SOUNDS];
 extern ma_sound *channels[MAX_CHANNELS];
-extern multi_tap_delay_node *delay_nodes[MAX_CHANNELS];
-extern reverb_node *reverb_nodes[MAX_CHANNELS];
-extern ma_uint64 drain_until_frame[MAX_CHANNELS];
 extern int sound_count;
 extern int engine_initialized;
 extern int context_initialized;
 extern int using_null_backend;
+extern int using_offline_engine;
 
 #endif // NATIVE_AUDIO_H
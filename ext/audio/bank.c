@@ -0,0 +1,88 @@
+// ============================================================================
+// bank.c - Packed sound banks for native_audio
+// ============================================================================
+
+#include <string.h>
+#include "bank.h"
+
+// ============================================================================
+// File Format
+// ============================================================================
+
+#define BANK_HEADER_SIZE 16
+#define BANK_ENTRY_SIZE 32
+
+static const char bank_magic[8] = { 'N', 'A', 'B', 'A', 'N', 'K', 0, 0 };
+
+// Fields are read byte by byte: the index is packed, and banks are written
+// little-endian whatever the platform
+static ma_uint32 read_u32(const unsigned char *p)
+{
+    return (ma_uint32)p[0] | ((ma_uint32)p[1] << 8) | ((ma_uint32)p[2] << 16) | ((ma_uint32)p[3] << 24);
+}
+
+static ma_uint64 read_u64(const unsigned char *p)
+{
+    return (ma_uint64)read_u32(p) | ((ma_uint64)read_u32(p + 4) << 32);
+}
+
+static const unsigned char *entry_record(const file_map *pMap, ma_uint32 index)
+{
+    return pMap->pData + BANK_HEADER_SIZE + (size_t)index * BANK_ENTRY_SIZE;
+}
+
+// Ranges are compared by subtraction so huge offsets can't wrap around
+static ma_bool32 range_valid(ma_uint64 offset, ma_uint64 length, size_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ma_result bank_open(const char *path, file_map *pMap, ma_uint32 *pCount)
+{
+    if (!file_map_open(path, pMap)) {
+        return MA_DOES_NOT_EXIST;
+    }
+
+    const unsigned char *pData = pMap->pData;
+    size_t size = pMap->size;
+    ma_bool32 valid = size >= BANK_HEADER_SIZE &&
+                      memcmp(pData, bank_magic, sizeof(bank_magic)) == 0 &&
+                      read_u32(pData + 8) == BANK_VERSION;
+
+    ma_uint32 count = valid ? read_u32(pData + 12) : 0;
+    valid = valid && count <= (size - BANK_HEADER_SIZE) / BANK_ENTRY_SIZE;
+
+    for (ma_uint32 i = 0; valid && i < count; i++) {
+        const unsigned char *pRecord = entry_record(pMap, i);
+        valid = range_valid(read_u64(pRecord), read_u64(pRecord + 8), size) &&
+                read_u64(pRecord + 8) > 0 &&
+                range_valid(read_u32(pRecord + 16), read_u32(pRecord + 20), size) &&
+                read_u32(pRecord + 20) > 0;
+    }
+
+    if (!valid) {
+        file_map_close(pMap);
+        return MA_INVALID_FILE;
+    }
+
+    *pCount = count;
+    return MA_SUCCESS;
+}
+
+void bank_get_entry(const file_map *pMap, ma_uint32 index, bank_entry *pEntry)
+{
+    const unsigned char *pRecord = entry_record(pMap, index);
+
+    pEntry->pData = pMap->pData + read_u64(pRecord);
+    pEntry->size = (size_t)read_u64(pRecord + 8);
+    pEntry->name = (const char *)pMap->pData + read_u32(pRecord + 16);
+    pEntry->name_length = read_u32(pRecord + 20);
+
+    // Padded with NULs, but not necessarily terminated
+    memcpy(pEntry->format, pRecord + 24, BANK_FORMAT_CAP);
+    pEntry->format[BANK_FORMAT_CAP] = '\0';
+}
@@ -0,0 +1,52 @@
+// ============================================================================
+// bank.h - Packed sound banks for native_audio
+// ============================================================================
+
+#ifndef BANK_H
+#define BANK_H
+
+#include "miniaudio.h"
+#include "file_map.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define BANK_VERSION 1
+#define BANK_FORMAT_CAP 8
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// One clip in a bank: its name, and the original file's bytes inside the
+// mapping
+typedef struct {
+    const char *name;                   // Not NUL-terminated
+    size_t name_length;
+    const void *pData;
+    size_t size;
+    char format[BANK_FORMAT_CAP + 1];   // Extension hint, "" if none
+} bank_entry;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// A bank is many sound files packed into one, behind an index of names,
+// so a level's worth of clips is one open and one mapping. Layout
+// (little-endian):
+//
+//   header   "NABANK\0\0", u32 version, u32 entry count
+//   index    per entry: u64 data offset, u64 data size, u32 name offset,
+//            u32 name length, char[8] format hint
+//   names    UTF-8, back to back
+//   data     each file as it was, starting on a 16-byte boundary
+//
+// Opening maps the file and checks every entry lies inside it. Returns
+// MA_DOES_NOT_EXIST if it can't be mapped and MA_INVALID_FILE if it isn't
+// a bank this version reads.
+ma_result bank_open(const char *path, file_map *pMap, ma_uint32 *pCount);
+void bank_get_entry(const file_map *pMap, ma_uint32 index, bank_entry *pEntry);
+
+#endif // BANK_H
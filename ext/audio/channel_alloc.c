@@ -0,0 +1,230 @@
+// ============================================================================
+// channel_alloc.c - Constant-time channel allocator
+// ============================================================================
+
+#include "audio.h"
+#include "channel_alloc.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// ============================================================================
+// Storage
+// ============================================================================
+
+#define IDLE_WORDS (MAX_CHANNELS / 64)   // Summary word covers up to 4096 channels
+
+static ma_uint64 idle_bits[IDLE_WORDS];
+static ma_uint64 idle_summary;           // Bit w set if idle_bits[w] != 0
+
+static int drain_heap[MAX_CHANNELS];
+static int drain_heap_size = 0;
+static int heap_pos[MAX_CHANNELS];       // Index into drain_heap, -1 if not draining
+static ma_uint64 drain_until[MAX_CHANNELS];
+static int channel_limit = MAX_CHANNELS; // Channels past this have no voice
+
+static inline int lowest_bit(ma_uint64 x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// ============================================================================
+// Idle Bitmap
+// ============================================================================
+
+static void idle_set(int channel)
+{
+    int word = channel >> 6;
+    idle_bits[word] |= (ma_uint64)1 << (channel & 63);
+    idle_summary |= (ma_uint64)1 << word;
+}
+
+static void idle_clear(int channel)
+{
+    int word = channel >> 6;
+    idle_bits[word] &= ~((ma_uint64)1 << (channel & 63));
+    if (idle_bits[word] == 0) {
+        idle_summary &= ~((ma_uint64)1 << word);
+    }
+}
+
+// ============================================================================
+// Drain Heap
+// ============================================================================
+
+static void heap_place(int index, int channel)
+{
+    drain_heap[index] = channel;
+    heap_pos[channel] = index;
+}
+
+static void heap_sift_up(int index)
+{
+    int channel = drain_heap[index];
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (drain_until[drain_heap[parent]] <= drain_until[channel]) break;
+        heap_place(index, drain_heap[parent]);
+        index = parent;
+    }
+
+    heap_place(index, channel);
+}
+
+static void heap_sift_down(int index)
+{
+    int channel = drain_heap[index];
+
+    for (;;) {
+        int child = index * 2 + 1;
+        if (child >= drain_heap_size) break;
+        if (child + 1 < drain_heap_size && drain_until[drain_heap[child + 1]] < drain_until[drain_heap[child]]) {
+            child++;
+        }
+        if (drain_until[channel] <= drain_until[drain_heap[child]]) break;
+        heap_place(index, drain_heap[child]);
+        index = child;
+    }
+
+    heap_place(index, channel);
+}
+
+static void heap_remove(int channel)
+{
+    int index = heap_pos[channel];
+    if (index < 0) {
+        return;
+    }
+
+    heap_pos[channel] = -1;
+    drain_heap_size--;
+
+    if (index == drain_heap_size) {
+        return;
+    }
+
+    // Move the last entry into the hole and restore heap order around it
+    int moved = drain_heap[drain_heap_size];
+    heap_place(index, moved);
+    heap_sift_up(index);
+    heap_sift_down(heap_pos[moved]);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Only channels below count are handed out; takes effect at the next reset
+void channel_alloc_set_limit(int count)
+{
+    channel_limit = count < MAX_CHANNELS ? count : MAX_CHANNELS;
+}
+
+void channel_alloc_reset(void)
+{
+    idle_summary = 0;
+    for (int w = 0; w < IDLE_WORDS; w++) {
+        idle_bits[w] = 0;
+    }
+    for (int i = 0; i < channel_limit; i++) {
+        idle_set(i);
+    }
+
+    drain_heap_size = 0;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        heap_pos[i] = -1;
+        drain_until[i] = 0;
+    }
+}
+
+// Lowest idle channel, else the draining channel closest to silence, else -1
+int channel_alloc_next(void)
+{
+    if (idle_summary != 0) {
+        int word = lowest_bit(idle_summary);
+        return (word << 6) + lowest_bit(idle_bits[word]);
+    }
+
+    if (drain_heap_size > 0) {
+        return drain_heap[0];
+    }
+
+    return -1;
+}
+
+void channel_alloc_mark_playing(int channel)
+{
+    idle_clear(channel);
+    heap_remove(channel);
+    drain_until[channel] = 0;
+}
+
+void channel_alloc_start_drain(int channel, ma_uint64 until_frame)
+{
+    idle_clear(channel);
+    drain_until[channel] = until_frame;
+
+    if (heap_pos[channel] >= 0) {
+        heap_sift_up(heap_pos[channel]);
+        heap_sift_down(heap_pos[channel]);
+        return;
+    }
+
+    heap_place(drain_heap_size, channel);
+    drain_heap_size++;
+    heap_sift_up(drain_heap_size - 1);
+}
+
+// Pops the next channel whose drain deadline has passed and marks it idle
+ma_bool32 channel_alloc_pop_expired(ma_uint64 now, int *pChannel)
+{
+    if (drain_heap_size == 0 || drain_until[drain_heap[0]] > now) {
+        return MA_FALSE;
+    }
+
+    int channel = drain_heap[0];
+    heap_remove(channel);
+    drain_until[channel] = 0;
+    idle_set(channel);
+
+    *pChannel = channel;
+    return MA_TRUE;
+}
+
+// Cuts a drain short, making the channel idle straight away
+void channel_alloc_release(int channel)
+{
+    heap_remove(channel);
+    drain_until[channel] = 0;
+    idle_set(channel);
+}
+
+ma_bool32 channel_alloc_is_draining(int channel)
+{
+    return heap_pos[channel] >= 0;
+}
+
+ma_uint64 channel_alloc_drain_deadline(int channel)
+{
+    return drain_until[channel];
+}
+
+// Draining channels in heap order, for visiting without a full sweep.
+// Indices are invalidated by any other call into the allocator.
+int channel_alloc_draining_count(void)
+{
+    return drain_heap_size;
+}
+
+int channel_alloc_draining_at(int index)
+{
+    return drain_heap[index];
+}
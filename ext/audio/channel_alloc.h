@@ -0,0 +1,32 @@
+// ============================================================================
+// channel_alloc.h - Constant-time channel allocator for native_audio
+// ============================================================================
+
+#ifndef CHANNEL_ALLOC_H
+#define CHANNEL_ALLOC_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Every channel is in exactly one state:
+//   idle     - in a two-level bitmap, lowest index handed out first
+//   draining - in a min-heap keyed by the frame its effect tail ends
+//   playing  - in neither
+void channel_alloc_set_limit(int count);
+void channel_alloc_reset(void);
+
+int channel_alloc_next(void);
+void channel_alloc_mark_playing(int channel);
+void channel_alloc_start_drain(int channel, ma_uint64 until_frame);
+ma_bool32 channel_alloc_pop_expired(ma_uint64 now, int *pChannel);
+void channel_alloc_release(int channel);
+
+ma_bool32 channel_alloc_is_draining(int channel);
+ma_uint64 channel_alloc_drain_deadline(int channel);
+int channel_alloc_draining_count(void);
+int channel_alloc_draining_at(int index);
+
+#endif // CHANNEL_ALLOC_H
@@ -0,0 +1,94 @@
+// ============================================================================
+// clip_index.c - Hash index for finding an already loaded clip
+// ============================================================================
+
+#include "clip_index.h"
+
+// ============================================================================
+// Storage
+// ============================================================================
+
+// Open addressing with linear probing. Removal shifts the rest of the run
+// back instead of leaving tombstones, so probes stay short.
+typedef struct {
+    ma_uint64 hash;
+    int clip_id;               // -1 if empty
+} index_slot;
+
+static index_slot slots[CLIP_INDEX_SIZE];
+
+#define SLOT_MASK (CLIP_INDEX_SIZE - 1)
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// FNV-1a, 64-bit
+ma_uint64 clip_index_hash(const void *pData, size_t size, ma_uint64 seed)
+{
+    const unsigned char *bytes = (const unsigned char *)pData;
+    ma_uint64 hash = 14695981039346656037ULL ^ seed;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+void clip_index_reset(void)
+{
+    for (int i = 0; i < CLIP_INDEX_SIZE; i++) {
+        slots[i].clip_id = -1;
+    }
+}
+
+int clip_index_find(ma_uint64 hash, clip_index_match match, const void *pKey)
+{
+    for (ma_uint32 i = (ma_uint32)hash & SLOT_MASK; slots[i].clip_id >= 0; i = (i + 1) & SLOT_MASK) {
+        if (slots[i].hash == hash && match(slots[i].clip_id, pKey)) {
+            return slots[i].clip_id;
+        }
+    }
+
+    return -1;
+}
+
+void clip_index_insert(ma_uint64 hash, int clip_id)
+{
+    ma_uint32 i = (ma_uint32)hash & SLOT_MASK;
+
+    while (slots[i].clip_id >= 0) {
+        i = (i + 1) & SLOT_MASK;
+    }
+
+    slots[i].hash = hash;
+    slots[i].clip_id = clip_id;
+}
+
+void clip_index_remove(ma_uint64 hash, int clip_id)
+{
+    ma_uint32 i = (ma_uint32)hash & SLOT_MASK;
+
+    while (slots[i].clip_id >= 0 && slots[i].clip_id != clip_id) {
+        i = (i + 1) & SLOT_MASK;
+    }
+
+    if (slots[i].clip_id < 0) {
+        return;
+    }
+
+    // Pull back later entries whose home is at or before the hole
+    ma_uint32 hole = i;
+    for (ma_uint32 j = (i + 1) & SLOT_MASK; slots[j].clip_id >= 0; j = (j + 1) & SLOT_MASK) {
+        ma_uint32 home = (ma_uint32)slots[j].hash & SLOT_MASK;
+
+        if (((j - home) & SLOT_MASK) >= ((j - hole) & SLOT_MASK)) {
+            slots[hole] = slots[j];
+            hole = j;
+        }
+    }
+
+    slots[hole].clip_id = -1;
+}
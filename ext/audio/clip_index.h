@@ -0,0 +1,31 @@
+// ============================================================================
+// clip_index.h - Hash index for finding an already loaded clip
+// ============================================================================
+
+#ifndef CLIP_INDEX_H
+#define CLIP_INDEX_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define CLIP_INDEX_SIZE 2048   // Power of two, at least twice MAX_SOUNDS
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Maps a 64-bit key hash to clip IDs. Hashes can collide, so lookups take a
+// callback that checks the full key against a candidate clip.
+typedef ma_bool32 (*clip_index_match)(int clip_id, const void *pKey);
+
+ma_uint64 clip_index_hash(const void *pData, size_t size, ma_uint64 seed);
+
+void clip_index_reset(void);
+int clip_index_find(ma_uint64 hash, clip_index_match match, const void *pKey);
+void clip_index_insert(ma_uint64 hash, int clip_id);
+void clip_index_remove(ma_uint64 hash, int clip_id);
+
+#endif // CLIP_INDEX_H
@@ -0,0 +1,263 @@
+// ============================================================================
+// clip_registry.c - Clip slot allocation and lifetime tracking
+// ============================================================================
+
+#include "audio.h"
+#include "clip_registry.h"
+
+// ============================================================================
+// Storage
+// ============================================================================
+
+typedef enum {
+    CLIP_FREE,
+    CLIP_LOADED,
+    CLIP_RETIRED
+} clip_state;
+
+static clip_state states[MAX_SOUNDS];
+static int refs[MAX_SOUNDS];
+static int attached[MAX_SOUNDS];            // Of refs, voices in the graph
+static int owners[MAX_SOUNDS];
+static ma_uint32 generations[MAX_SOUNDS];   // Bumped on retire so stale handles can tell
+
+static int free_slots[MAX_SOUNDS];          // Stack, lowest slot on top after a reset
+static int free_count = 0;
+
+// Resident list, doubly linked through the slot index; -1 ends it
+static ma_bool32 resident[MAX_SOUNDS];
+static int newer[MAX_SOUNDS];
+static int older[MAX_SOUNDS];
+static int newest = -1;
+static int oldest = -1;
+static ma_uint64 bytes[MAX_SOUNDS];        // Decoded size, kept while evicted
+static ma_uint64 resident_bytes = 0;
+
+static void list_unlink(int clip_id)
+{
+    if (newer[clip_id] >= 0) older[newer[clip_id]] = older[clip_id];
+    else newest = older[clip_id];
+
+    if (older[clip_id] >= 0) newer[older[clip_id]] = newer[clip_id];
+    else oldest = newer[clip_id];
+}
+
+static void list_push_newest(int clip_id)
+{
+    newer[clip_id] = -1;
+    older[clip_id] = newest;
+
+    if (newest >= 0) newer[newest] = clip_id;
+    else oldest = clip_id;
+
+    newest = clip_id;
+}
+
+static void push_free(int clip_id)
+{
+    states[clip_id] = CLIP_FREE;
+    free_slots[free_count++] = clip_id;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void clip_registry_reset(void)
+{
+    free_count = 0;
+    newest = -1;
+    oldest = -1;
+    resident_bytes = 0;
+
+    for (int i = MAX_SOUNDS - 1; i >= 0; i--) {
+        refs[i] = 0;
+        attached[i] = 0;
+        resident[i] = MA_FALSE;
+        bytes[i] = 0;
+        push_free(i);
+    }
+}
+
+// Takes a free slot and marks it loaded. Returns -1 when every slot is in use.
+int clip_registry_acquire(void)
+{
+    if (free_count == 0) {
+        return -1;
+    }
+
+    int clip_id = free_slots[--free_count];
+    states[clip_id] = CLIP_LOADED;
+    refs[clip_id] = 0;
+    attached[clip_id] = 0;
+    owners[clip_id] = 1;
+    bytes[clip_id] = 0;
+
+    return clip_id;
+}
+
+ma_bool32 clip_registry_full(void)
+{
+    return free_count == 0;
+}
+
+// Slots not on the free list: loaded clips, and retired ones voices still hold
+int clip_registry_live_count(void)
+{
+    return MAX_SOUNDS - free_count;
+}
+
+// Unloads a clip. Returns true if the slot was freed straight away, false
+// if voices still hold it.
+ma_bool32 clip_registry_retire(int clip_id)
+{
+    if (states[clip_id] != CLIP_LOADED) {
+        return MA_FALSE;
+    }
+
+    generations[clip_id]++;
+    clip_registry_evict(clip_id);
+
+    if (refs[clip_id] == 0) {
+        push_free(clip_id);
+        return MA_TRUE;
+    }
+
+    states[clip_id] = CLIP_RETIRED;
+    return MA_FALSE;
+}
+
+void clip_registry_retain(int clip_id)
+{
+    refs[clip_id]++;
+}
+
+// Drops a voice's reference. Returns true if that freed a retired slot.
+ma_bool32 clip_registry_release(int clip_id)
+{
+    refs[clip_id]--;
+
+    if (refs[clip_id] == 0 && states[clip_id] == CLIP_RETIRED) {
+        push_free(clip_id);
+        return MA_TRUE;
+    }
+
+    return MA_FALSE;
+}
+
+void clip_registry_attach(int clip_id)
+{
+    attached[clip_id]++;
+}
+
+void clip_registry_detach(int clip_id)
+{
+    attached[clip_id]--;
+}
+
+ma_bool32 clip_registry_in_use(int clip_id)
+{
+    return attached[clip_id] > 0;
+}
+
+// References held by voices out of the graph, whose copies can be dropped
+int clip_registry_idle_refs(int clip_id)
+{
+    return refs[clip_id] - attached[clip_id];
+}
+
+void clip_registry_own(int clip_id)
+{
+    owners[clip_id]++;
+}
+
+// Returns the owners left
+int clip_registry_disown(int clip_id)
+{
+    if (owners[clip_id] > 0) {
+        owners[clip_id]--;
+    }
+
+    return owners[clip_id];
+}
+
+ma_bool32 clip_registry_is_loaded(int clip_id)
+{
+    return states[clip_id] == CLIP_LOADED;
+}
+
+ma_uint32 clip_registry_generation(int clip_id)
+{
+    return generations[clip_id];
+}
+
+// ============================================================================
+// Residency
+// ============================================================================
+
+void clip_registry_make_resident(int clip_id)
+{
+    if (resident[clip_id]) {
+        return;
+    }
+
+    resident[clip_id] = MA_TRUE;
+    resident_bytes += bytes[clip_id];
+    list_push_newest(clip_id);
+}
+
+void clip_registry_evict(int clip_id)
+{
+    if (!resident[clip_id]) {
+        return;
+    }
+
+    resident[clip_id] = MA_FALSE;
+    resident_bytes -= bytes[clip_id];
+    list_unlink(clip_id);
+}
+
+ma_bool32 clip_registry_is_resident(int clip_id)
+{
+    return resident[clip_id];
+}
+
+// Marks the clip as the most recently played
+void clip_registry_touch(int clip_id)
+{
+    if (resident[clip_id] && newest != clip_id) {
+        list_unlink(clip_id);
+        list_push_newest(clip_id);
+    }
+}
+
+void clip_registry_set_bytes(int clip_id, ma_uint64 size)
+{
+    if (resident[clip_id]) {
+        resident_bytes = resident_bytes - bytes[clip_id] + size;
+    }
+
+    bytes[clip_id] = size;
+}
+
+ma_uint64 clip_registry_bytes(int clip_id)
+{
+    return bytes[clip_id];
+}
+
+ma_uint64 clip_registry_resident_bytes(void)
+{
+    return resident_bytes;
+}
+
+// Least recently played resident clip, -1 if none
+int clip_registry_oldest(void)
+{
+    return oldest;
+}
+
+// Next resident clip towards the most recently played end, -1 at the end
+int clip_registry_newer(int clip_id)
+{
+    return newer[clip_id];
+}
@@ -0,0 +1,63 @@
+// ============================================================================
+// clip_registry.h - Clip slot allocation and lifetime tracking
+// ============================================================================
+
+#ifndef CLIP_REGISTRY_H
+#define CLIP_REGISTRY_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Every clip slot is in exactly one state:
+//   free    - on the free list, handed out again by clip_registry_acquire
+//   loaded  - playable
+//   retired - unloaded, but voices still hold copies of it; the slot goes
+//             back on the free list when the last one lets go
+//
+// Voices hold a reference while their sound is a copy of the clip, so a
+// slot is never reused while a voice could still mistake it for its clip.
+void clip_registry_reset(void);
+
+int clip_registry_acquire(void);
+ma_bool32 clip_registry_full(void);
+int clip_registry_live_count(void);
+ma_bool32 clip_registry_retire(int clip_id);
+
+void clip_registry_retain(int clip_id);
+ma_bool32 clip_registry_release(int clip_id);
+
+// Of those references, the voices in the graph (playing or draining), so
+// eviction can tell a clip in use without visiting every voice
+void clip_registry_attach(int clip_id);
+void clip_registry_detach(int clip_id);
+ma_bool32 clip_registry_in_use(int clip_id);
+int clip_registry_idle_refs(int clip_id);
+
+// Owners are the loads that returned this clip; loading an already loaded
+// file hands back the same clip with one more owner. A clip is unloaded
+// when its last owner lets go.
+void clip_registry_own(int clip_id);
+int clip_registry_disown(int clip_id);
+
+ma_bool32 clip_registry_is_loaded(int clip_id);
+ma_uint32 clip_registry_generation(int clip_id);
+
+// Loaded clips whose decoded audio is in memory are "resident" and kept on
+// a list from most to least recently played, with their decoded sizes
+// summed. Eviction walks it from the least recently played end.
+void clip_registry_make_resident(int clip_id);
+void clip_registry_evict(int clip_id);
+ma_bool32 clip_registry_is_resident(int clip_id);
+void clip_registry_touch(int clip_id);
+
+void clip_registry_set_bytes(int clip_id, ma_uint64 bytes);
+ma_uint64 clip_registry_bytes(int clip_id);
+ma_uint64 clip_registry_resident_bytes(void);
+
+int clip_registry_oldest(void);
+int clip_registry_newer(int clip_id);
+
+#endif // CLIP_REGISTRY_H
@@ -5,51 +5,216 @@
 #include <stdlib.h>
 #include <string.h>
 #include "delay_node.h"
+#include "simd.h"
 
 // ============================================================================
-// DSP Callback
+// Commands
 // ============================================================================
 
-static void multi_tap_delay_process(ma_node *pNode, const float **ppFramesIn,
-                                     ma_uint32 *pFrameCountIn, float **ppFramesOut,
-                                     ma_uint32 *pFrameCountOut)
+enum {
+    DELAY_CMD_SET_TAP,      // frames and value (volume) for tap index
+    DELAY_CMD_CLEAR_TAP
+};
+
+// A removed tap keeps reading for one more delay, which plays out the echo
+// of everything that came in before the removal, and then goes quiet
+static void delay_release_tap(delay_tap *tap)
+{
+    if (tap->active && tap->release_frames == 0 && tap->delay_frames > 0 && tap->volume != 0.0f) {
+        tap->release_frames = tap->delay_frames;
+    } else if (tap->release_frames == 0) {
+        tap->active = MA_FALSE;
+    }
+}
+
+// Render side: picks up every change posted since the last block, so a
+// block never sees half of one. A snapshot is older than anything still
+// queued after its queue_tail, so it goes first.
+static void delay_apply_commands(multi_tap_delay_node *pNode)
+{
+    param_command command;
+
+    if (spsc_triple_take(&pNode->snapshot_slots)) {
+        const delay_snapshot *snapshot = &pNode->snapshots[pNode->snapshot_slots.front];
+        for (int i = 0; i < MAX_TAPS_PER_CHANNEL; i++) {
+            if (snapshot->taps[i].active) {
+                pNode->taps[i] = snapshot->taps[i];
+            } else {
+                delay_release_tap(&pNode->taps[i]);
+            }
+        }
+        param_queue_skip_to(&pNode->commands, snapshot->queue_tail);
+    }
+
+    while (param_queue_pop(&pNode->commands, &command)) {
+        delay_tap *tap = &pNode->taps[command.index];
+
+        if (command.op == DELAY_CMD_SET_TAP) {
+            tap->delay_frames = command.frames;
+            tap->volume = command.value;
+            tap->active = MA_TRUE;
+            tap->release_frames = 0;
+        } else {
+            delay_release_tap(tap);
+        }
+    }
+}
+
+// Ruby side. While the render is behind (the queue filled up), every
+// change publishes the whole tap table instead; single commands resume
+// once the render has taken the latest table.
+static void delay_post_tap(multi_tap_delay_node *pNode, int tap_id)
+{
+    if (pNode->snapshotting && !spsc_triple_pending(&pNode->snapshot_slots)) {
+        pNode->snapshotting = MA_FALSE;
+    }
+
+    if (!pNode->snapshotting) {
+        const delay_tap *tap = &pNode->control_taps[tap_id];
+        param_command command = {
+            tap->active ? DELAY_CMD_SET_TAP : DELAY_CMD_CLEAR_TAP, (ma_uint32)tap_id, tap->delay_frames, tap->volume
+        };
+
+        if (param_queue_push(&pNode->commands, &command)) {
+            return;
+        }
+        pNode->snapshotting = MA_TRUE;
+    }
+
+    delay_snapshot *snapshot = &pNode->snapshots[pNode->snapshot_slots.back];
+    memcpy(snapshot->taps, pNode->control_taps, sizeof(snapshot->taps));
+    snapshot->queue_tail = param_queue_tail(&pNode->commands);
+    spsc_triple_publish(&pNode->snapshot_slots);
+}
+
+// ============================================================================
+// DSP Kernel
+// ============================================================================
+
+// Renders one block of at most DELAY_BLOCK_FRAMES. The whole input block is
+// written to the ring first; the guard region past max_delay_frames keeps
+// those writes clear of anything a tap still has to read. Each tap then adds
+// a contiguous span of history (split in two at the wrap point).
+static void delay_render_block(multi_tap_delay_node *node, const float *pFramesIn,
+                               float *pFramesOut, ma_uint32 frameCount)
 {
-    multi_tap_delay_node *node = (multi_tap_delay_node *)pNode;
-    const float *pFramesIn = ppFramesIn[0];
-    float *pFramesOut = ppFramesOut[0];
-    ma_uint32 frameCount = *pFrameCountOut;
     ma_uint32 numChannels = node->channels;
+    ma_uint32 bufferSize = node->buffer_size;
+    ma_uint32 writePos = node->write_pos;
+    ma_uint32 filled = node->filled_frames;
+    size_t frameBytes = numChannels * sizeof(float);
+
+    // Write the block into the ring, wrapping at most once
+    ma_uint32 firstFrames = bufferSize - writePos;
+    if (firstFrames > frameCount) firstFrames = frameCount;
+
+    if (pFramesIn != NULL) {
+        memcpy(node->buffer + writePos * numChannels, pFramesIn, firstFrames * frameBytes);
+        memcpy(node->buffer, pFramesIn + firstFrames * numChannels, (frameCount - firstFrames) * frameBytes);
+        memcpy(pFramesOut, pFramesIn, frameCount * frameBytes);  // Dry signal
+    } else {
+        memset(node->buffer + writePos * numChannels, 0, firstFrames * frameBytes);
+        memset(node->buffer, 0, (frameCount - firstFrames) * frameBytes);
+        memset(pFramesOut, 0, frameCount * frameBytes);
+    }
+
+    for (ma_uint32 iTap = 0; iTap < MAX_TAPS_PER_CHANNEL; iTap++) {
+        delay_tap *tap = &node->taps[iTap];
+        if (!tap->active) continue;
 
-    for (ma_uint32 iFrame = 0; iFrame < frameCount; iFrame++) {
-        for (ma_uint32 iChannel = 0; iChannel < numChannels; iChannel++) {
-            ma_uint32 sampleIndex = iFrame * numChannels + iChannel;
-            float inputSample = pFramesIn[sampleIndex];
-
-            // Write to circular buffer
-            ma_uint32 writeIndex = (node->write_pos * numChannels) + iChannel;
-            node->buffer[writeIndex] = inputSample;
-
-            // Start with dry signal
-            float outputSample = inputSample;
-
-            // Mix in all active taps
-            for (ma_uint32 iTap = 0; iTap < MAX_TAPS_PER_CHANNEL; iTap++) {
-                if (node->taps[iTap].active) {
-                    ma_uint32 delayFrames = node->taps[iTap].delay_frames;
-                    if (delayFrames > 0 && delayFrames <= node->buffer_size) {
-                        ma_uint32 readPos = (node->write_pos + node->buffer_size - delayFrames) % node->buffer_size;
-                        ma_uint32 readIndex = (readPos * numChannels) + iChannel;
-                        outputSample += node->buffer[readIndex] * node->taps[iTap].volume;
-                    }
-                }
+        // A removed tap stops once its last echo is out
+        ma_uint32 endFrame = frameCount;
+        if (tap->release_frames > 0) {
+            if (tap->release_frames <= frameCount) {
+                endFrame = tap->release_frames;
+                tap->release_frames = 0;
+                tap->active = MA_FALSE;
+            } else {
+                tap->release_frames -= frameCount;
             }
+        }
+
+        ma_uint32 delayFrames = tap->delay_frames;
+        float volume = tap->volume;
+        if (delayFrames == 0 || volume == 0.0f) continue;
+
+        // Only frames written since the last reset are valid history
+        ma_uint32 startFrame = (delayFrames > filled) ? delayFrames - filled : 0;
+        if (startFrame >= endFrame) continue;
+
+        ma_uint32 readPos = (writePos + startFrame + bufferSize - delayFrames) % bufferSize;
+        ma_uint32 remaining = endFrame - startFrame;
+        float *pOut = pFramesOut + startFrame * numChannels;
+
+        while (remaining > 0) {
+            ma_uint32 span = bufferSize - readPos;
+            if (span > remaining) span = remaining;
+
+            simd_mix_scaled(pOut, node->buffer + readPos * numChannels, volume, span * numChannels);
+
+            pOut += span * numChannels;
+            remaining -= span;
+            readPos = 0;
+        }
+    }
 
-            pFramesOut[sampleIndex] = outputSample;
+    writePos += frameCount;
+    if (writePos >= bufferSize) writePos -= bufferSize;
+    node->write_pos = writePos;
+
+    filled += frameCount;
+    node->filled_frames = (filled < bufferSize) ? filled : bufferSize;
+}
+
+void multi_tap_delay_render(multi_tap_delay_node *pNode, const float *pFramesIn,
+                            float *pFramesOut, ma_uint32 frameCount)
+{
+    delay_apply_commands(pNode);
+
+    ma_uint32 numChannels = pNode->channels;
+    ma_uint32 totalFrames = frameCount;
+    float inputPeak = 0.0f;
+
+    while (frameCount > 0) {
+        ma_uint32 blockFrames = (frameCount < DELAY_BLOCK_FRAMES) ? frameCount : DELAY_BLOCK_FRAMES;
+
+        if (pFramesIn != NULL) {
+            float blockPeak = simd_peak(pFramesIn, blockFrames * numChannels);
+            if (blockPeak > inputPeak) inputPeak = blockPeak;
         }
 
-        // Advance write position
-        node->write_pos = (node->write_pos + 1) % node->buffer_size;
+        delay_render_block(pNode, pFramesIn, pFramesOut, blockFrames);
+
+        if (pFramesIn != NULL) pFramesIn += blockFrames * numChannels;
+        pFramesOut += blockFrames * numChannels;
+        frameCount -= blockFrames;
     }
+
+    // Track how long the input has been silent so the tail end can be detected
+    if (inputPeak > DELAY_SILENCE_THRESHOLD) {
+        pNode->quiet_frames = 0;
+    } else if (pNode->quiet_frames < pNode->buffer_size) {
+        pNode->quiet_frames += totalFrames;
+    }
+
+    ma_uint32 sounding = 0;
+    for (int i = 0; i < MAX_TAPS_PER_CHANNEL; i++) {
+        sounding += pNode->taps[i].active ? 1 : 0;
+    }
+    pNode->sounding_taps = sounding;
+}
+
+// ============================================================================
+// DSP Callback
+// ============================================================================
+
+static void multi_tap_delay_process(ma_node *pNode, const float **ppFramesIn,
+                                     ma_uint32 *pFrameCountIn, float **ppFramesOut,
+                                     ma_uint32 *pFrameCountOut)
+{
+    const float *pFramesIn = (ppFramesIn != NULL) ? ppFramesIn[0] : NULL;  // NULL once the source stops
+
+    multi_tap_delay_render((multi_tap_delay_node *)pNode, pFramesIn, ppFramesOut[0], *pFrameCountOut);
 }
 
 static ma_node_vtable g_multi_tap_delay_vtable = {
@@ -57,7 +222,7 @@ static ma_node_vtable g_multi_tap_delay_vtable = {
     NULL,  // onGetRequiredInputFrameCount
     1,     // inputBusCount
     1,     // outputBusCount
-    0      // flags
+    MA_NODE_FLAG_CONTINUOUS_PROCESSING | MA_NODE_FLAG_ALLOW_NULL_INPUT  // Keep running for the tail
 };
 
 // ============================================================================
@@ -75,9 +240,14 @@ ma_result multi_tap_delay_init(multi_tap_delay_node *pNode, ma_node_graph *pNode
 
     pNode->sample_rate = sampleRate;
     pNode->channels = numChannels;
-    pNode->buffer_size = (ma_uint32)(sampleRate * MAX_DELAY_SECONDS);
+    pNode->max_delay_frames = (ma_uint32)(sampleRate * MAX_DELAY_SECONDS);
+    pNode->buffer_size = pNode->max_delay_frames + DELAY_BLOCK_FRAMES;
     pNode->write_pos = 0;
+    pNode->filled_frames = 0;
     pNode->tap_count = 0;
+    pNode->snapshotting = MA_FALSE;
+    param_queue_init(&pNode->commands);
+    spsc_triple_init(&pNode->snapshot_slots);
 
     // Allocate circular buffer (frames * channels)
     pNode->buffer = (float *)calloc(pNode->buffer_size * numChannels, sizeof(float));
@@ -90,6 +260,8 @@ ma_result multi_tap_delay_init(multi_tap_delay_node *pNode, ma_node_graph *pNode
         pNode->taps[i].active = MA_FALSE;
         pNode->taps[i].delay_frames = 0;
         pNode->taps[i].volume = 0.0f;
+        pNode->taps[i].release_frames = 0;
+        pNode->control_taps[i] = pNode->taps[i];
     }
 
     // Set up node configuration
@@ -116,10 +288,96 @@ void multi_tap_delay_uninit(multi_tap_delay_node *pNode)
     }
 }
 
+void multi_tap_delay_reset(multi_tap_delay_node *pNode)
+{
+    if (pNode == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < MAX_TAPS_PER_CHANNEL; i++) {
+        pNode->taps[i].active = MA_FALSE;
+        pNode->taps[i].delay_frames = 0;
+        pNode->taps[i].volume = 0.0f;
+        pNode->taps[i].release_frames = 0;
+        pNode->control_taps[i] = pNode->taps[i];
+    }
+
+    pNode->tap_count = 0;
+    pNode->sounding_taps = 0;
+    pNode->snapshotting = MA_FALSE;
+    param_queue_init(&pNode->commands);
+    spsc_triple_init(&pNode->snapshot_slots);
+    multi_tap_delay_clear_history(pNode);
+}
+
+void multi_tap_delay_clear_history(multi_tap_delay_node *pNode)
+{
+    if (pNode == NULL) {
+        return;
+    }
+
+    // Stale samples are masked by filled_frames, so the buffer needn't be zeroed
+    pNode->write_pos = 0;
+    pNode->filled_frames = 0;
+    pNode->quiet_frames = 0;
+}
+
+// ============================================================================
+// Tail Tracking
+// ============================================================================
+
+// Upper bound on how long output continues after the input goes silent
+ma_uint32 multi_tap_delay_tail_frames(multi_tap_delay_node *pNode)
+{
+    ma_uint32 longest = 0;
+
+    if (pNode == NULL) {
+        return 0;
+    }
+
+    // Removed taps still playing out their echo are no longer listed
+    if (pNode->sounding_taps > pNode->tap_count) {
+        return pNode->max_delay_frames;
+    }
+
+    for (int i = 0; i < MAX_TAPS_PER_CHANNEL; i++) {
+        if (pNode->control_taps[i].active && pNode->control_taps[i].delay_frames > longest) {
+            longest = pNode->control_taps[i].delay_frames;
+        }
+    }
+
+    return longest;
+}
+
+// True once no tap can reach anything audible: the input has been silent
+// for longer than the longest tap, or every tap is gone and the render
+// has played out the echoes of removed ones
+ma_bool32 multi_tap_delay_is_silent(multi_tap_delay_node *pNode)
+{
+    if (pNode == NULL) {
+        return MA_TRUE;
+    }
+
+    if (pNode->tap_count == 0 && pNode->sounding_taps == 0) {
+        return MA_TRUE;
+    }
+
+    return pNode->quiet_frames > multi_tap_delay_tail_frames(pNode);
+}
+
 // ============================================================================
 // Tap Management
 // ============================================================================
 
+// Called from the Ruby thread. Each change lands in control_taps and is
+// posted to the render.
+
+static ma_uint32 delay_frames_for(multi_tap_delay_node *pNode, float time_ms)
+{
+    ma_uint32 delayFrames = (ma_uint32)((time_ms / 1000.0f) * pNode->sample_rate);
+    return (delayFrames > pNode->max_delay_frames) ? pNode->max_delay_frames : delayFrames;
+}
+
 int multi_tap_delay_add_tap(multi_tap_delay_node *pNode, float time_ms, float volume)
 {
     if (pNode == NULL) {
@@ -128,15 +386,13 @@ int multi_tap_delay_add_tap(multi_tap_delay_node *pNode, float time_ms, float vo
 
     // Find first inactive tap slot
     for (int i = 0; i < MAX_TAPS_PER_CHANNEL; i++) {
-        if (!pNode->taps[i].active) {
-            ma_uint32 delayFrames = (ma_uint32)((time_ms / 1000.0f) * pNode->sample_rate);
-            if (delayFrames > pNode->buffer_size) {
-                delayFrames = pNode->buffer_size;
-            }
-            pNode->taps[i].delay_frames = delayFrames;
-            pNode->taps[i].volume = volume;
-            pNode->taps[i].active = MA_TRUE;
+        delay_tap *tap = &pNode->control_taps[i];
+        if (!tap->active) {
+            tap->delay_frames = delay_frames_for(pNode, time_ms);
+            tap->volume = volume;
+            tap->active = MA_TRUE;
             pNode->tap_count++;
+            delay_post_tap(pNode, i);
             return i;
         }
     }
@@ -150,11 +406,13 @@ void multi_tap_delay_remove_tap(multi_tap_delay_node *pNode, int tap_id)
         return;
     }
 
-    if (pNode->taps[tap_id].active) {
-        pNode->taps[tap_id].active = MA_FALSE;
-        pNode->taps[tap_id].delay_frames = 0;
-        pNode->taps[tap_id].volume = 0.0f;
+    delay_tap *tap = &pNode->control_taps[tap_id];
+    if (tap->active) {
+        tap->active = MA_FALSE;
+        tap->delay_frames = 0;
+        tap->volume = 0.0f;
         pNode->tap_count--;
+        delay_post_tap(pNode, tap_id);
     }
 }
 
@@ -164,8 +422,9 @@ void multi_tap_delay_set_volume(multi_tap_delay_node *pNode, int tap_id, float v
         return;
     }
 
-    if (pNode->taps[tap_id].active) {
-        pNode->taps[tap_id].volume = volume;
+    if (pNode->control_taps[tap_id].active) {
+        pNode->control_taps[tap_id].volume = volume;
+        delay_post_tap(pNode, tap_id);
     }
 }
 
@@ -175,11 +434,8 @@ void multi_tap_delay_set_time(multi_tap_delay_node *pNode, int tap_id, float tim
         return;
     }
 
-    if (pNode->taps[tap_id].active) {
-        ma_uint32 delayFrames = (ma_uint32)((time_ms / 1000.0f) * pNode->sample_rate);
-        if (delayFrames > pNode->buffer_size) {
-            delayFrames = pNode->buffer_size;
-        }
-        pNode->taps[tap_id].delay_frames = delayFrames;
+    if (pNode->control_taps[tap_id].active) {
+        pNode->control_taps[tap_id].delay_frames = delay_frames_for(pNode, time_ms);
+        delay_post_tap(pNode, tap_id);
     }
 }
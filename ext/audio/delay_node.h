@@ -6,6 +6,7 @@
 #define DELAY_NODE_H
 
 #include "miniaudio.h"
+#include "spsc_queue.h"
 
 // ============================================================================
 // Constants
@@ -13,6 +14,8 @@
 
 #define MAX_TAPS_PER_CHANNEL 16
 #define MAX_DELAY_SECONDS 2.0f
+#define DELAY_BLOCK_FRAMES 1024           // Guard region past the longest delay
+#define DELAY_SILENCE_THRESHOLD 0.0001f   // -80 dBFS
 
 // ============================================================================
 // Types
@@ -22,17 +25,37 @@ typedef struct {
     ma_uint32 delay_frames;
     float volume;
     ma_bool32 active;
+    ma_uint32 release_frames;   // Render only: echo left to play after removal
 } delay_tap;
 
+// The whole tap table, posted instead of single changes when the queue is
+// full. It supersedes every command before queue_tail.
+typedef struct {
+    delay_tap taps[MAX_TAPS_PER_CHANNEL];
+    ma_uint32 queue_tail;
+} delay_snapshot;
+
 typedef struct {
     ma_node_base base;
     float *buffer;
-    ma_uint32 buffer_size;      // Size in frames
+    ma_uint32 buffer_size;      // Size in frames (max_delay_frames + DELAY_BLOCK_FRAMES)
+    ma_uint32 max_delay_frames;
     ma_uint32 write_pos;
+    ma_uint32 filled_frames;    // Frames written since reset (capped at buffer_size)
+    volatile ma_uint32 quiet_frames;  // Consecutive input frames below the silence threshold
+    volatile ma_uint32 sounding_taps; // Taps the render still reads, removed ones included
     ma_uint32 channels;         // Audio channels (stereo = 2)
-    delay_tap taps[MAX_TAPS_PER_CHANNEL];
-    ma_uint32 tap_count;
+    delay_tap taps[MAX_TAPS_PER_CHANNEL];   // Read by the render
     ma_uint32 sample_rate;
+
+    // Tap changes are made to control_taps on the Ruby thread, then posted
+    // to the render, which copies them into taps between blocks
+    delay_tap control_taps[MAX_TAPS_PER_CHANNEL];
+    ma_uint32 tap_count;
+    param_queue commands;
+    ma_bool32 snapshotting;     // A post didn't fit; whole tables go until one is taken
+    delay_snapshot snapshots[3];
+    spsc_triple snapshot_slots;
 } multi_tap_delay_node;
 
 // ============================================================================
@@ -42,6 +65,15 @@ typedef struct {
 ma_result multi_tap_delay_init(multi_tap_delay_node *pNode, ma_node_graph *pNodeGraph,
                                 ma_uint32 sampleRate, ma_uint32 numChannels);
 void multi_tap_delay_uninit(multi_tap_delay_node *pNode);
+// Reset and clear_history write the render's state directly, so they're
+// only called while the node is out of the graph
+void multi_tap_delay_reset(multi_tap_delay_node *pNode);
+void multi_tap_delay_clear_history(multi_tap_delay_node *pNode);
+void multi_tap_delay_render(multi_tap_delay_node *pNode, const float *pFramesIn,
+                            float *pFramesOut, ma_uint32 frameCount);
+
+ma_uint32 multi_tap_delay_tail_frames(multi_tap_delay_node *pNode);
+ma_bool32 multi_tap_delay_is_silent(multi_tap_delay_node *pNode);
 
 int multi_tap_delay_add_tap(multi_tap_delay_node *pNode, float time_ms, float volume);
 void multi_tap_delay_remove_tap(multi_tap_delay_node *pNode, int tap_id);
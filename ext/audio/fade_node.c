@@ -0,0 +1,255 @@
+// ============================================================================
+// fade_node.c - Per-voice volume and pan ramps
+// ============================================================================
+
+#include <string.h>
+#include "fade_node.h"
+
+// ============================================================================
+// Commands
+// ============================================================================
+
+enum {
+    FADE_CMD_VOLUME,    // value to reach over frames, index holds the curve
+    FADE_CMD_PAN
+};
+
+// Render side: starts every ramp posted since the last block. A snapshot
+// is older than anything queued after its queue_tail, so it goes first.
+static void fade_apply_commands(fade_node *pNode)
+{
+    param_command command;
+
+    if (spsc_triple_take(&pNode->snapshot_slots)) {
+        const fade_snapshot *snapshot = &pNode->snapshots[pNode->snapshot_slots.front];
+        param_ramp_set(&pNode->volume, snapshot->volume);
+        param_ramp_set(&pNode->pan, snapshot->pan);
+        param_queue_skip_to(&pNode->commands, snapshot->queue_tail);
+    }
+
+    while (param_queue_pop(&pNode->commands, &command)) {
+        param_ramp *ramp = (command.op == FADE_CMD_VOLUME) ? &pNode->volume : &pNode->pan;
+        param_ramp_start(ramp, command.value, command.frames, (ramp_curve)command.index);
+    }
+}
+
+// Ruby side. While the render is behind (the queue filled up), every
+// change publishes both targets instead and the ramps jump to them;
+// single commands resume once the render has taken the latest set.
+static void fade_post(fade_node *pNode, ma_uint32 op, ma_uint32 frames, ramp_curve curve)
+{
+    if (pNode->snapshotting && !spsc_triple_pending(&pNode->snapshot_slots)) {
+        pNode->snapshotting = MA_FALSE;
+    }
+
+    if (!pNode->snapshotting) {
+        float value = (op == FADE_CMD_VOLUME) ? pNode->control_volume : pNode->control_pan;
+        param_command command = { op, (ma_uint32)curve, frames, value };
+
+        if (param_queue_push(&pNode->commands, &command)) {
+            return;
+        }
+        pNode->snapshotting = MA_TRUE;
+    }
+
+    fade_snapshot *snapshot = &pNode->snapshots[pNode->snapshot_slots.back];
+    snapshot->volume = pNode->control_volume;
+    snapshot->pan = pNode->control_pan;
+    snapshot->queue_tail = param_queue_tail(&pNode->commands);
+    spsc_triple_publish(&pNode->snapshot_slots);
+}
+
+// ============================================================================
+// DSP Kernel
+// ============================================================================
+
+// Balance panning, as the engine applies it: the far side is turned down
+// and the near side left alone
+static void balance_gains(float volume, float pan, float *pLeft, float *pRight)
+{
+    *pLeft = (pan > 0.0f) ? volume * (1.0f - pan) : volume;
+    *pRight = (pan < 0.0f) ? volume * (1.0f + pan) : volume;
+}
+
+void fade_render(fade_node *pNode, const float *pFramesIn, float *pFramesOut, ma_uint32 frameCount)
+{
+    fade_apply_commands(pNode);
+
+    ma_uint32 numChannels = pNode->channels;
+    ma_bool32 stereo = (numChannels == 2);
+
+    // On the first block the sound has already applied its own volume and
+    // pan. They're divided back out so the ramps hold from the first frame,
+    // and set to unity for the blocks after.
+    float undoLeft = 1.0f;
+    float undoRight = 1.0f;
+    if (pNode->sound != NULL) {
+        ma_sound_set_volume(pNode->sound, 1.0f);
+        ma_sound_set_pan(pNode->sound, 0.0f);
+        pNode->sound = NULL;
+
+        if (pNode->sound_volume == 0.0f) {
+            // Nothing to divide out; the ramps wait for the next block
+            memset(pFramesOut, 0, frameCount * numChannels * sizeof(float));
+            return;
+        }
+
+        float left, right;
+        balance_gains(pNode->sound_volume, stereo ? pNode->sound_pan : 0.0f, &left, &right);
+        undoLeft = (left != 0.0f) ? 1.0f / left : 0.0f;
+        undoRight = (right != 0.0f) ? 1.0f / right : 0.0f;
+    }
+
+    if (!param_ramp_active(&pNode->volume) && !param_ramp_active(&pNode->pan)) {
+        float left, right;
+        balance_gains(pNode->volume.value, stereo ? pNode->pan.value : 0.0f, &left, &right);
+        left *= undoLeft;
+        right *= undoRight;
+
+        if (stereo) {
+            for (ma_uint32 iFrame = 0; iFrame < frameCount; iFrame++) {
+                pFramesOut[iFrame * 2 + 0] = pFramesIn[iFrame * 2 + 0] * left;
+                pFramesOut[iFrame * 2 + 1] = pFramesIn[iFrame * 2 + 1] * right;
+            }
+        } else {
+            for (ma_uint32 i = 0; i < frameCount * numChannels; i++) {
+                pFramesOut[i] = pFramesIn[i] * left;
+            }
+        }
+        return;
+    }
+
+    for (ma_uint32 iFrame = 0; iFrame < frameCount; iFrame++) {
+        float volume = param_ramp_next(&pNode->volume);
+        float pan = param_ramp_next(&pNode->pan);
+        ma_uint32 base = iFrame * numChannels;
+
+        if (stereo) {
+            float left, right;
+            balance_gains(volume, pan, &left, &right);
+            pFramesOut[base + 0] = pFramesIn[base + 0] * left * undoLeft;
+            pFramesOut[base + 1] = pFramesIn[base + 1] * right * undoRight;
+        } else {
+            for (ma_uint32 ch = 0; ch < numChannels; ch++) {
+                pFramesOut[base + ch] = pFramesIn[base + ch] * volume * undoLeft;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// DSP Callback
+// ============================================================================
+
+static void fade_process(ma_node *pNode, const float **ppFramesIn,
+                         ma_uint32 *pFrameCountIn, float **ppFramesOut,
+                         ma_uint32 *pFrameCountOut)
+{
+    fade_render((fade_node *)pNode, ppFramesIn[0], ppFramesOut[0], *pFrameCountOut);
+}
+
+static ma_node_vtable g_fade_vtable = {
+    fade_process,
+    NULL,  // onGetRequiredInputFrameCount
+    1,     // inputBusCount
+    1,     // outputBusCount
+    0      // Nothing to add once the sound stops
+};
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+ma_result fade_init(fade_node *pNode, ma_node_graph *pNodeGraph,
+                    ma_uint32 sampleRate, ma_uint32 numChannels)
+{
+    if (pNode == NULL) {
+        return MA_INVALID_ARGS;
+    }
+
+    memset(pNode, 0, sizeof(*pNode));
+
+    pNode->sample_rate = sampleRate;
+    pNode->channels = numChannels;
+    fade_reset(pNode);
+
+    ma_uint32 channelsArray[1] = { numChannels };
+    ma_node_config nodeConfig = ma_node_config_init();
+    nodeConfig.vtable = &g_fade_vtable;
+    nodeConfig.pInputChannels = channelsArray;
+    nodeConfig.pOutputChannels = channelsArray;
+
+    return ma_node_init(pNodeGraph, &nodeConfig, NULL, &pNode->base);
+}
+
+void fade_uninit(fade_node *pNode)
+{
+    if (pNode == NULL) {
+        return;
+    }
+
+    ma_node_uninit(&pNode->base, NULL);
+}
+
+void fade_reset(fade_node *pNode)
+{
+    if (pNode == NULL) {
+        return;
+    }
+
+    param_ramp_set(&pNode->volume, 1.0f);
+    param_ramp_set(&pNode->pan, 0.0f);
+    pNode->sound = NULL;
+    pNode->control_volume = 1.0f;
+    pNode->control_pan = 0.0f;
+    pNode->snapshotting = MA_FALSE;
+    param_queue_init(&pNode->commands);
+    spsc_triple_init(&pNode->snapshot_slots);
+}
+
+// Starts from the sound's current volume and pan. The Ruby thread is the
+// only one setting them until now, so reading them here is safe. A sound
+// that hasn't been started is handed over straight away; one started with
+// a start time still ahead counts as started, as the graph may reach it
+// before the next call from Ruby.
+void fade_take_over(fade_node *pNode, ma_sound *pSound)
+{
+    float volume = ma_sound_get_volume(pSound);
+    float pan = ma_sound_get_pan(pSound);
+
+    param_ramp_set(&pNode->volume, volume);
+    param_ramp_set(&pNode->pan, pan);
+    pNode->control_volume = volume;
+    pNode->control_pan = pan;
+
+    if (ma_node_get_state(pSound) == ma_node_state_started) {
+        pNode->sound = pSound;
+        pNode->sound_volume = volume;
+        pNode->sound_pan = pan;
+    } else {
+        ma_sound_set_volume(pSound, 1.0f);
+        ma_sound_set_pan(pSound, 0.0f);
+        pNode->sound = NULL;
+    }
+}
+
+// ============================================================================
+// Parameter Control
+// ============================================================================
+
+// Called from the Ruby thread. Each ramp is posted to the render, which
+// starts it at the top of its next block.
+
+void fade_ramp_volume(fade_node *pNode, float volume, ma_uint32 frames, ramp_curve curve)
+{
+    if (pNode == NULL) return;
+    pNode->control_volume = volume;
+    fade_post(pNode, FADE_CMD_VOLUME, frames, curve);
+}
+
+void fade_ramp_pan(fade_node *pNode, float pan, ma_uint32 frames)
+{
+    if (pNode == NULL) return;
+    pNode->control_pan = pan;
+    fade_post(pNode, FADE_CMD_PAN, frames, RAMP_LINEAR);
+}
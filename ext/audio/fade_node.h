@@ -0,0 +1,66 @@
+// ============================================================================
+// fade_node.h - Per-voice volume and pan ramps for native_audio
+// ============================================================================
+
+#ifndef FADE_NODE_H
+#define FADE_NODE_H
+
+#include "miniaudio.h"
+#include "spsc_queue.h"
+#include "param_ramp.h"
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// Volume and pan targets, posted whole when the queue is full. Supersedes
+// every command before queue_tail.
+typedef struct {
+    float volume;
+    float pan;
+    ma_uint32 queue_tail;
+} fade_snapshot;
+
+// Takes over a sound's volume and pan so they can be ramped per sample.
+// A playing sound keeps applying its own until the node's first block,
+// which sets them to unity and carries on from where they were; after
+// that the Ruby thread only changes them through the node.
+typedef struct {
+    ma_node_base base;
+    ma_uint32 channels;
+    ma_uint32 sample_rate;
+
+    // Render side
+    param_ramp volume;
+    param_ramp pan;             // Stereo balance, as ma_sound_set_pan applies it
+    ma_sound *sound;            // Still scaled by its own volume and pan, or NULL
+    float sound_volume;
+    float sound_pan;
+
+    // Ruby side: targets of the last change, and the queue to the render
+    float control_volume;
+    float control_pan;
+    param_queue commands;
+    ma_bool32 snapshotting;     // A post didn't fit; whole sets go until one is taken
+    fade_snapshot snapshots[3];
+    spsc_triple snapshot_slots;
+} fade_node;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ma_result fade_init(fade_node *pNode, ma_node_graph *pNodeGraph,
+                    ma_uint32 sampleRate, ma_uint32 numChannels);
+void fade_uninit(fade_node *pNode);
+// Take over and reset write the render's state directly, so they're only
+// called while the node is out of the graph
+void fade_take_over(fade_node *pNode, ma_sound *pSound);
+void fade_reset(fade_node *pNode);
+void fade_render(fade_node *pNode, const float *pFramesIn, float *pFramesOut, ma_uint32 frameCount);
+
+// Frames 0 jumps straight to the target. Pan ramps are always linear.
+void fade_ramp_volume(fade_node *pNode, float volume, ma_uint32 frames, ramp_curve curve);
+void fade_ramp_pan(fade_node *pNode, float pan, ma_uint32 frames);
+
+#endif // FADE_NODE_H
@@ -0,0 +1,79 @@
+// ============================================================================
+// file_map.c - Read-only file mappings for native_audio
+// ============================================================================
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "file_map.h"
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ma_bool32 file_map_open(const char *path, file_map *pMap)
+{
+    pMap->pData = NULL;
+    pMap->size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return MA_FALSE;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            pMap->pData = (unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);   // The view keeps the mapping alive
+        }
+        pMap->size = (size_t)size.QuadPart;
+    }
+
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return MA_FALSE;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *pData = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (pData != MAP_FAILED) {
+            pMap->pData = (unsigned char *)pData;
+        }
+        pMap->size = (size_t)info.st_size;
+    }
+
+    close(fd);              // The mapping keeps the file open
+#endif
+
+    return pMap->pData != NULL;
+}
+
+void file_map_close(file_map *pMap)
+{
+    if (pMap->pData == NULL) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(pMap->pData);
+#else
+    munmap(pMap->pData, pMap->size);
+#endif
+
+    pMap->pData = NULL;
+    pMap->size = 0;
+}
@@ -0,0 +1,39 @@
+// ============================================================================
+// file_map.h - Read-only file mappings for native_audio
+// ============================================================================
+
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Types
+// ============================================================================
+
+typedef struct {
+    unsigned char *pData;       // NULL if nothing is mapped
+    size_t size;
+} file_map;
+
+// PCM frames read in place from a mapped file. They stay valid until the
+// mapping is closed.
+typedef struct {
+    const void *pFrames;
+    ma_uint64 frameCount;
+    ma_format format;
+    ma_uint32 channels;
+    ma_uint32 sampleRate;
+    file_map map;
+} mapped_pcm;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Maps a whole file read-only. Pages are shared with the OS file cache and
+// only read from disk when touched. Empty files can't be mapped.
+ma_bool32 file_map_open(const char *path, file_map *pMap);
+void file_map_close(file_map *pMap);
+
+#endif // FILE_MAP_H
@@ -0,0 +1,289 @@
+// ============================================================================
+// memory_vfs.c - Serves in-memory clip data to the resource manager
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory_vfs.h"
+
+// ============================================================================
+// State
+// ============================================================================
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    ma_uint32 serial;       // Part of the name, so reused indexes get new names
+} memory_file;
+
+// An open handle: either a cursor into a registered buffer, or a file
+// opened through the default VFS
+typedef struct {
+    const memory_file *file;
+    size_t cursor;
+    ma_vfs_file fallback;
+} memory_handle;
+
+typedef struct {
+    ma_vfs_callbacks cb;
+    ma_default_vfs fallback;
+} memory_vfs;
+
+static memory_vfs vfs;
+static ma_bool32 vfs_initialized = MA_FALSE;
+static memory_file files[MEMORY_VFS_MAX_FILES];
+static int file_count = 0;                        // High-water mark
+static int free_files[MEMORY_VFS_MAX_FILES];
+static int free_count = 0;
+static ma_uint32 next_serial = 1;
+
+// ============================================================================
+// Callbacks
+// ============================================================================
+
+static const memory_file *lookup(const char *pFilePath)
+{
+    size_t prefix_len = strlen(MEMORY_VFS_PREFIX);
+
+    if (strncmp(pFilePath, MEMORY_VFS_PREFIX, prefix_len) != 0) {
+        return NULL;
+    }
+
+    // Names are "<prefix><index>-<serial>[.ext]"
+    char *end;
+    long index = strtol(pFilePath + prefix_len, &end, 10);
+    if (*end != '-' || index < 0 || index >= file_count) {
+        return NULL;
+    }
+
+    unsigned long serial = strtoul(end + 1, NULL, 10);
+    if (files[index].data == NULL || files[index].serial != (ma_uint32)serial) {
+        return NULL;
+    }
+
+    return &files[index];
+}
+
+static ma_result vfs_open(ma_vfs *pVFS, const char *pFilePath, ma_uint32 openMode, ma_vfs_file *pFile)
+{
+    memory_handle *handle = (memory_handle *)calloc(1, sizeof(memory_handle));
+    if (handle == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+
+    handle->file = lookup(pFilePath);
+
+    if (handle->file == NULL) {
+        ma_result result = ma_vfs_open(&vfs.fallback, pFilePath, openMode, &handle->fallback);
+        if (result != MA_SUCCESS) {
+            free(handle);
+            return result;
+        }
+    } else if ((openMode & MA_OPEN_MODE_WRITE) != 0) {
+        free(handle);
+        return MA_ACCESS_DENIED;
+    }
+
+    (void)pVFS;
+    *pFile = handle;
+    return MA_SUCCESS;
+}
+
+static ma_result vfs_open_w(ma_vfs *pVFS, const wchar_t *pFilePath, ma_uint32 openMode, ma_vfs_file *pFile)
+{
+    // Registered names are always narrow, so wide paths are real files
+    memory_handle *handle = (memory_handle *)calloc(1, sizeof(memory_handle));
+    if (handle == NULL) {
+        return MA_OUT_OF_MEMORY;
+    }
+
+    ma_result result = ma_vfs_open_w(&vfs.fallback, pFilePath, openMode, &handle->fallback);
+    if (result != MA_SUCCESS) {
+        free(handle);
+        return result;
+    }
+
+    (void)pVFS;
+    *pFile = handle;
+    return MA_SUCCESS;
+}
+
+static ma_result vfs_close(ma_vfs *pVFS, ma_vfs_file file)
+{
+    memory_handle *handle = (memory_handle *)file;
+    ma_result result = MA_SUCCESS;
+
+    if (handle->file == NULL) {
+        result = ma_vfs_close(&vfs.fallback, handle->fallback);
+    }
+
+    (void)pVFS;
+    free(handle);
+    return result;
+}
+
+static ma_result vfs_read(ma_vfs *pVFS, ma_vfs_file file, void *pDst, size_t sizeInBytes, size_t *pBytesRead)
+{
+    memory_handle *handle = (memory_handle *)file;
+
+    (void)pVFS;
+    if (handle->file == NULL) {
+        return ma_vfs_read(&vfs.fallback, handle->fallback, pDst, sizeInBytes, pBytesRead);
+    }
+
+    size_t available = handle->file->size - handle->cursor;
+    size_t count = (sizeInBytes < available) ? sizeInBytes : available;
+
+    memcpy(pDst, handle->file->data + handle->cursor, count);
+    handle->cursor += count;
+
+    if (pBytesRead != NULL) {
+        *pBytesRead = count;
+    }
+
+    return (count == 0 && sizeInBytes > 0) ? MA_AT_END : MA_SUCCESS;
+}
+
+static ma_result vfs_write(ma_vfs *pVFS, ma_vfs_file file, const void *pSrc, size_t sizeInBytes, size_t *pBytesWritten)
+{
+    memory_handle *handle = (memory_handle *)file;
+
+    (void)pVFS;
+    if (handle->file == NULL) {
+        return ma_vfs_write(&vfs.fallback, handle->fallback, pSrc, sizeInBytes, pBytesWritten);
+    }
+
+    return MA_ACCESS_DENIED;
+}
+
+static ma_result vfs_seek(ma_vfs *pVFS, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin)
+{
+    memory_handle *handle = (memory_handle *)file;
+
+    (void)pVFS;
+    if (handle->file == NULL) {
+        return ma_vfs_seek(&vfs.fallback, handle->fallback, offset, origin);
+    }
+
+    ma_int64 base = 0;
+    if (origin == ma_seek_origin_current) {
+        base = (ma_int64)handle->cursor;
+    } else if (origin == ma_seek_origin_end) {
+        base = (ma_int64)handle->file->size;
+    }
+
+    ma_int64 target = base + offset;
+    if (target < 0 || target > (ma_int64)handle->file->size) {
+        return MA_BAD_SEEK;
+    }
+
+    handle->cursor = (size_t)target;
+    return MA_SUCCESS;
+}
+
+static ma_result vfs_tell(ma_vfs *pVFS, ma_vfs_file file, ma_int64 *pCursor)
+{
+    memory_handle *handle = (memory_handle *)file;
+
+    (void)pVFS;
+    if (handle->file == NULL) {
+        return ma_vfs_tell(&vfs.fallback, handle->fallback, pCursor);
+    }
+
+    *pCursor = (ma_int64)handle->cursor;
+    return MA_SUCCESS;
+}
+
+static ma_result vfs_info(ma_vfs *pVFS, ma_vfs_file file, ma_file_info *pInfo)
+{
+    memory_handle *handle = (memory_handle *)file;
+
+    (void)pVFS;
+    if (handle->file == NULL) {
+        return ma_vfs_info(&vfs.fallback, handle->fallback, pInfo);
+    }
+
+    pInfo->sizeInBytes = handle->file->size;
+    return MA_SUCCESS;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ma_vfs *memory_vfs_get(void)
+{
+    if (!vfs_initialized) {
+        ma_default_vfs_init(&vfs.fallback, NULL);
+        vfs.cb.onOpen = vfs_open;
+        vfs.cb.onOpenW = vfs_open_w;
+        vfs.cb.onClose = vfs_close;
+        vfs.cb.onRead = vfs_read;
+        vfs.cb.onWrite = vfs_write;
+        vfs.cb.onSeek = vfs_seek;
+        vfs.cb.onTell = vfs_tell;
+        vfs.cb.onInfo = vfs_info;
+        vfs_initialized = MA_TRUE;
+    }
+
+    return &vfs;
+}
+
+void memory_vfs_reset(void)
+{
+    for (int i = 0; i < file_count; i++) {
+        files[i].data = NULL;
+        files[i].size = 0;
+    }
+
+    file_count = 0;
+    free_count = 0;
+}
+
+int memory_vfs_add(const void *pData, size_t size, const char *extension, char *pName, size_t nameCap)
+{
+    int index;
+    if (free_count > 0) {
+        index = free_files[--free_count];
+    } else if (file_count < MEMORY_VFS_MAX_FILES) {
+        index = file_count++;
+    } else {
+        return -1;
+    }
+
+    files[index].data = (const unsigned char *)pData;
+    files[index].size = size;
+    files[index].serial = next_serial++;
+
+    if (extension != NULL && extension[0] != '\0') {
+        snprintf(pName, nameCap, MEMORY_VFS_PREFIX "%d-%u.%s", index, files[index].serial, extension);
+    } else {
+        snprintf(pName, nameCap, MEMORY_VFS_PREFIX "%d-%u", index, files[index].serial);
+    }
+
+    return index;
+}
+
+ma_bool32 memory_vfs_find(const char *name, const void **ppData, size_t *pSize)
+{
+    const memory_file *file = lookup(name);
+    if (file == NULL) {
+        return MA_FALSE;
+    }
+
+    *ppData = file->data;
+    *pSize = file->size;
+    return MA_TRUE;
+}
+
+void memory_vfs_remove(int index)
+{
+    if (index < 0 || index >= file_count || files[index].data == NULL) {
+        return;
+    }
+
+    files[index].data = NULL;
+    files[index].size = 0;
+    free_files[free_count++] = index;
+}
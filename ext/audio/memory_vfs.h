@@ -0,0 +1,41 @@
+// ============================================================================
+// memory_vfs.h - Serves in-memory clip data to the resource manager
+// ============================================================================
+
+#ifndef MEMORY_VFS_H
+#define MEMORY_VFS_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define MEMORY_VFS_MAX_FILES 1024
+#define MEMORY_VFS_PREFIX "native_audio:memory/"
+#define MEMORY_VFS_NAME_CAP 64
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// A VFS that opens registered buffers by name and hands every other path to
+// miniaudio's default VFS. Buffers are read in place, never copied; the
+// caller keeps them alive and unchanged until they're removed.
+ma_vfs *memory_vfs_get(void);
+void memory_vfs_reset(void);
+
+// Registers a buffer and writes the name to open it by into pName.
+// The extension (may be NULL) is kept on the name so the decoder tries the
+// matching format first. Returns the file index, or -1 if the table is full.
+int memory_vfs_add(const void *pData, size_t size, const char *extension, char *pName, size_t nameCap);
+
+// Finds the buffer a name refers to, for callers that can use the bytes
+// in place instead of reading them through the VFS
+ma_bool32 memory_vfs_find(const char *name, const void **ppData, size_t *pSize);
+
+// Frees the index for reuse. Names handed out for it stop resolving, so a
+// cached lookup can never reach whatever is registered there next.
+void memory_vfs_remove(int index);
+
+#endif // MEMORY_VFS_H
@@ -0,0 +1,113 @@
+// ============================================================================
+// param_ramp.h - Per-sample parameter ramps for native_audio's DSP nodes
+// ============================================================================
+
+#ifndef PARAM_RAMP_H
+#define PARAM_RAMP_H
+
+#include <math.h>
+#include "miniaudio.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define RAMP_FLOOR 0.0001f  // -80 dB; exponential ramps start or end here instead of at 0
+
+// ============================================================================
+// Types
+// ============================================================================
+
+typedef enum {
+    RAMP_LINEAR,
+    RAMP_EXPONENTIAL    // Constant dB per frame, for gains
+} ramp_curve;
+
+// Render side only. A ramp is started by a command at the top of a block
+// and then advanced one frame at a time.
+typedef struct {
+    float value;
+    float target;
+    float step;             // Added (linear) or multiplied in (exponential) per frame
+    ma_uint32 remaining;    // Frames until value reaches target
+    ramp_curve curve;
+} param_ramp;
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+static inline void param_ramp_set(param_ramp *r, float value)
+{
+    r->value = value;
+    r->target = value;
+    r->step = 0.0f;
+    r->remaining = 0;
+    r->curve = RAMP_LINEAR;
+}
+
+// Heads from the current value to target over frames. Frame n of the ramp
+// (counting from 1) is a fraction n/frames of the way there, so the last
+// one lands on target exactly.
+static inline void param_ramp_start(param_ramp *r, float target, ma_uint32 frames, ramp_curve curve)
+{
+    if (frames == 0) {
+        param_ramp_set(r, target);
+        return;
+    }
+
+    r->target = target;
+    r->remaining = frames;
+    r->curve = curve;
+
+    if (curve == RAMP_EXPONENTIAL) {
+        float from = (r->value > RAMP_FLOOR) ? r->value : RAMP_FLOOR;
+        float to = (target > RAMP_FLOOR) ? target : RAMP_FLOOR;
+        r->value = from;
+        r->step = powf(to / from, 1.0f / (float)frames);
+    } else {
+        r->step = (target - r->value) / (float)frames;
+    }
+}
+
+static inline ma_bool32 param_ramp_active(const param_ramp *r)
+{
+    return r->remaining > 0;
+}
+
+// Value for the next frame
+static inline float param_ramp_next(param_ramp *r)
+{
+    if (r->remaining == 0) {
+        return r->value;
+    }
+
+    if (--r->remaining == 0) {
+        r->value = r->target;
+    } else if (r->curve == RAMP_EXPONENTIAL) {
+        r->value *= r->step;
+    } else {
+        r->value += r->step;
+    }
+
+    return r->value;
+}
+
+// Moves on by frames without producing them (a bypassed or idle block)
+static inline void param_ramp_skip(param_ramp *r, ma_uint32 frames)
+{
+    if (frames >= r->remaining) {
+        r->value = r->target;
+        r->remaining = 0;
+        return;
+    }
+
+    r->remaining -= frames;
+    if (r->curve == RAMP_EXPONENTIAL) {
+        r->value *= powf(r->step, (float)frames);
+    } else {
+        r->value += r->step * (float)frames;
+    }
+}
+
+#endif // PARAM_RAMP_H
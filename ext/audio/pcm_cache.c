@@ -0,0 +1,223 @@
+// ============================================================================
+// pcm_cache.c - On-disk cache of decoded clips for native_audio
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "pcm_cache.h"
+#include "clip_index.h"
+
+// ============================================================================
+// File Format
+// ============================================================================
+
+// Header, then the source path (to rule out hash collisions), then the
+// interleaved float frames starting on a 16-byte boundary
+typedef struct {
+    char magic[8];
+    ma_uint32 version;
+    ma_uint32 channels;
+    ma_uint32 sample_rate;
+    ma_uint32 path_length;
+    ma_uint64 frame_count;
+    ma_int64 source_mtime;     // Nanoseconds
+    ma_uint64 source_size;
+    ma_uint64 data_offset;
+} cache_header;
+
+static const char cache_magic[8] = { 'N', 'A', 'P', 'C', 'M', 0, 0, 0 };
+
+static char cache_dir[PCM_CACHE_PATH_CAP];
+static ma_bool32 cache_enabled = MA_FALSE;
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static ma_bool32 stat_source(const char *path, ma_int64 *pMtime, ma_uint64 *pSize)
+{
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(path, &info) != 0) {
+        return MA_FALSE;
+    }
+#else
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return MA_FALSE;
+    }
+#endif
+
+    // Nanoseconds where the platform keeps them, so a file rewritten within
+    // the second still misses. Where st_mtim exists, st_mtime is a macro
+    // for its seconds.
+#if defined(__APPLE__)
+    *pMtime = (ma_int64)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32) && defined(st_mtime)
+    *pMtime = (ma_int64)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#else
+    *pMtime = (ma_int64)info.st_mtime * 1000000000;
+#endif
+    *pSize = (ma_uint64)info.st_size;
+    return MA_TRUE;
+}
+
+// Everything that changes the decoded frames goes into the name
+static ma_bool32 cache_file_name(const char *path, ma_int64 mtime, ma_uint64 size, ma_uint32 channels,
+                                 ma_uint32 sampleRate, char *pName, size_t nameCap)
+{
+    ma_uint64 key[5] = { (ma_uint64)mtime, size, channels, sampleRate, PCM_CACHE_VERSION };
+    ma_uint64 hash = clip_index_hash(path, strlen(path), 0);
+    hash = clip_index_hash(key, sizeof(key), hash);
+
+    int written = snprintf(pName, nameCap, "%s/%016llx.pcm", cache_dir, (unsigned long long)hash);
+    return written > 0 && (size_t)written < nameCap;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void pcm_cache_set_dir(const char *dir)
+{
+    if (dir == NULL || strlen(dir) >= sizeof(cache_dir)) {
+        cache_enabled = MA_FALSE;
+        return;
+    }
+
+    strcpy(cache_dir, dir);
+    cache_enabled = MA_TRUE;
+}
+
+const char *pcm_cache_get_dir(void)
+{
+    return cache_enabled ? cache_dir : NULL;
+}
+
+ma_bool32 pcm_cache_open(const char *path, ma_uint32 channels, ma_uint32 sampleRate, mapped_pcm *pPCM)
+{
+    ma_int64 mtime;
+    ma_uint64 source_size;
+    char name[PCM_CACHE_PATH_CAP];
+
+    if (!cache_enabled || !stat_source(path, &mtime, &source_size) ||
+        !cache_file_name(path, mtime, source_size, channels, sampleRate, name, sizeof(name))) {
+        return MA_FALSE;
+    }
+
+    file_map map;
+    if (!file_map_open(name, &map)) {
+        return MA_FALSE;
+    }
+
+    const unsigned char *pMapping = map.pData;
+    size_t size = map.size;
+
+    // Anything that doesn't describe exactly this source is ignored
+    const cache_header *header = (const cache_header *)pMapping;
+    size_t path_length = strlen(path);
+    ma_bool32 valid = size >= sizeof(cache_header) &&
+                      memcmp(header->magic, cache_magic, sizeof(cache_magic)) == 0 &&
+                      header->version == PCM_CACHE_VERSION &&
+                      header->sample_rate == sampleRate &&
+                      header->channels > 0 &&
+                      (channels == 0 || header->channels == channels) &&
+                      header->source_mtime == mtime &&
+                      header->source_size == source_size &&
+                      header->path_length == path_length &&
+                      sizeof(cache_header) + path_length <= size &&
+                      memcmp(pMapping + sizeof(cache_header), path, path_length) == 0 &&
+                      header->data_offset <= size &&
+                      header->frame_count <= (size - header->data_offset) / (header->channels * sizeof(float));
+
+    if (!valid) {
+        file_map_close(&map);
+        return MA_FALSE;
+    }
+
+    pPCM->pFrames = pMapping + header->data_offset;
+    pPCM->frameCount = header->frame_count;
+    pPCM->format = ma_format_f32;
+    pPCM->channels = header->channels;
+    pPCM->sampleRate = header->sample_rate;
+    pPCM->map = map;
+    return MA_TRUE;
+}
+
+ma_result pcm_cache_store(const char *path, ma_uint32 requestedChannels, const float *pFrames,
+                          ma_uint64 frameCount, ma_uint32 channels, ma_uint32 sampleRate)
+{
+    ma_int64 mtime;
+    ma_uint64 source_size;
+    char name[PCM_CACHE_PATH_CAP];
+    char temp_name[PCM_CACHE_PATH_CAP + 32];
+
+    if (!cache_enabled || !stat_source(path, &mtime, &source_size) ||
+        !cache_file_name(path, mtime, source_size, requestedChannels, sampleRate, name, sizeof(name))) {
+        return MA_INVALID_ARGS;
+    }
+
+    // Written under a temporary name and renamed into place, so another
+    // process never maps a half-written file
+#ifdef _WIN32
+    snprintf(temp_name, sizeof(temp_name), "%s.%d.tmp", name, _getpid());
+#else
+    snprintf(temp_name, sizeof(temp_name), "%s.%d.tmp", name, (int)getpid());
+#endif
+
+    FILE *file = fopen(temp_name, "wb");
+    if (file == NULL) {
+        return MA_ACCESS_DENIED;
+    }
+
+    size_t path_length = strlen(path);
+    cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = PCM_CACHE_VERSION;
+    header.channels = channels;
+    header.sample_rate = sampleRate;
+    header.path_length = (ma_uint32)path_length;
+    header.frame_count = frameCount;
+    header.source_mtime = mtime;
+    header.source_size = source_size;
+    header.data_offset = (sizeof(header) + path_length + 15) & ~(ma_uint64)15;
+
+    static const char padding[16] = { 0 };
+    size_t pad = (size_t)header.data_offset - sizeof(header) - path_length;
+    size_t samples = (size_t)(frameCount * channels);
+
+    ma_bool32 written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                        fwrite(path, 1, path_length, file) == path_length &&
+                        fwrite(padding, 1, pad, file) == pad &&
+                        fwrite(pFrames, sizeof(float), samples, file) == samples;
+    written = (fclose(file) == 0) && written;
+
+#ifdef _WIN32
+    if (written && !MoveFileExA(temp_name, name, MOVEFILE_REPLACE_EXISTING)) {
+        written = MA_FALSE;
+    }
+#else
+    if (written && rename(temp_name, name) != 0) {
+        written = MA_FALSE;
+    }
+#endif
+
+    if (!written) {
+        remove(temp_name);
+        return MA_ERROR;
+    }
+
+    return MA_SUCCESS;
+}
@@ -0,0 +1,40 @@
+// ============================================================================
+// pcm_cache.h - On-disk cache of decoded clips for native_audio
+// ============================================================================
+
+#ifndef PCM_CACHE_H
+#define PCM_CACHE_H
+
+#include "miniaudio.h"
+#include "file_map.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define PCM_CACHE_VERSION 2
+#define PCM_CACHE_PATH_CAP 4096
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Cache files live in one directory, named by a hash of the source path,
+// its modification time and size, and the format it was decoded to. An
+// edited source gets a new name, so stale files are never read. NULL
+// turns the cache off.
+void pcm_cache_set_dir(const char *dir);
+const char *pcm_cache_get_dir(void);
+
+// channels is what the clip was decoded to, 0 for the source's own count.
+// Opening maps the cache file's 32-bit float frames; close them with
+// file_map_close. It fails (and the caller decodes as usual) if there's no
+// cache file, or the source can't be stat'ed.
+ma_bool32 pcm_cache_open(const char *path, ma_uint32 channels, ma_uint32 sampleRate, mapped_pcm *pPCM);
+
+// Writes decoded frames for the next launch. Best effort: a failed write
+// leaves no partial file behind.
+ma_result pcm_cache_store(const char *path, ma_uint32 requestedChannels, const float *pFrames,
+                          ma_uint64 frameCount, ma_uint32 channels, ma_uint32 sampleRate);
+
+#endif // PCM_CACHE_H
@@ -0,0 +1,69 @@
+// ============================================================================
+// reverb_bus.c - Shared send/return reverb buses
+// ============================================================================
+
+#include <stdlib.h>
+#include "reverb_bus.h"
+
+// ============================================================================
+// Bus Storage
+// ============================================================================
+
+static reverb_node *buses[MAX_REVERB_BUSES];
+static int bus_count = 0;
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+int reverb_bus_create(ma_engine *pEngine)
+{
+    if (bus_count >= MAX_REVERB_BUSES) {
+        return -1;
+    }
+
+    reverb_node *pNode = (reverb_node *)malloc(sizeof(reverb_node));
+    if (pNode == NULL) {
+        return -1;
+    }
+
+    ma_result result = reverb_init(pNode, ma_engine_get_node_graph(pEngine),
+                                   ma_engine_get_sample_rate(pEngine),
+                                   ma_engine_get_channels(pEngine));
+    if (result != MA_SUCCESS) {
+        free(pNode);
+        return -1;
+    }
+
+    // Return path only: the dry signal reaches the endpoint through each voice
+    reverb_set_dry(pNode, 0.0f);
+    reverb_set_enabled(pNode, MA_TRUE);
+    ma_node_attach_output_bus(&pNode->base, 0, ma_engine_get_endpoint(pEngine), 0);
+
+    buses[bus_count] = pNode;
+    return bus_count++;
+}
+
+void reverb_bus_uninit_all(void)
+{
+    for (int i = 0; i < bus_count; i++) {
+        reverb_uninit(buses[i]);
+        free(buses[i]);
+        buses[i] = NULL;
+    }
+
+    bus_count = 0;
+}
+
+// ============================================================================
+// Bus Access
+// ============================================================================
+
+reverb_node *reverb_bus_get(int bus)
+{
+    if (bus < 0 || bus >= bus_count) {
+        return NULL;
+    }
+
+    return buses[bus];
+}
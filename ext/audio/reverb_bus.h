@@ -0,0 +1,29 @@
+// ============================================================================
+// reverb_bus.h - Shared send/return reverb buses for native_audio
+// ============================================================================
+
+#ifndef REVERB_BUS_H
+#define REVERB_BUS_H
+
+#include "miniaudio.h"
+#include "reverb_node.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define MAX_REVERB_BUSES 16
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// A bus is a single fully-wet reverb_node wired to the endpoint. Voices feed
+// it through a gain-scaled splitter output, so any number of voices in one
+// environment share one reverb.
+int reverb_bus_create(ma_engine *pEngine);
+void reverb_bus_uninit_all(void);
+
+reverb_node *reverb_bus_get(int bus);
+
+#endif // REVERB_BUS_H
@@ -2,9 +2,11 @@
 // reverb_node.c - Schroeder reverb node implementation
 // ============================================================================
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include "reverb_node.h"
+#include "simd.h"
 
 // ============================================================================
 // Delay Line Helpers
@@ -29,106 +31,650 @@ static void delay_line_free(delay_line *dl)
     }
 }
 
-static inline float delay_line_read(delay_line *dl)
+static void delay_line_clear(delay_line *dl)
 {
-    return dl->buffer[dl->pos];
+    if (dl->buffer) {
+        memset(dl->buffer, 0, dl->size * sizeof(float));
+    }
+    dl->pos = 0;
 }
 
-static inline void delay_line_write(delay_line *dl, float value)
+// ============================================================================
+// Comb Banks
+// ============================================================================
+
+// A comb reads and rewrites the same slot each frame, so over any run that
+// doesn't wrap, its reads are one contiguous span untouched by the run's
+// own writes. The vector banks load four frames of each comb, transpose so
+// the four combs sit in the four lanes, step the damping filters together
+// and transpose back for contiguous writes. The comb sum is taken across
+// the untransposed spans in the scalar order, so output is bit-identical.
+
+// Longest span (up to maxFrames) before any of the lines wraps
+static ma_uint32 lines_run(const delay_line *lines, int count, ma_uint32 maxFrames)
 {
-    dl->buffer[dl->pos] = value;
-    dl->pos = (dl->pos + 1) % dl->size;
+    ma_uint32 run = maxFrames;
+    for (int i = 0; i < count; i++) {
+        ma_uint32 left = lines[i].size - lines[i].pos;
+        if (left < run) run = left;
+    }
+    return run;
 }
 
-// ============================================================================
-// Filter Processing
-// ============================================================================
+static void lines_advance(delay_line *lines, int count, ma_uint32 frames)
+{
+    for (int i = 0; i < count; i++) {
+        lines[i].pos += frames;
+        if (lines[i].pos == lines[i].size) lines[i].pos = 0;
+    }
+}
 
-// Comb filter: output = buffer[pos], then write input + feedback * output (with damping)
-static inline float comb_process(delay_line *dl, float input, float feedback,
-                                  float damp, float *damp_prev)
+// Scalar reference: one channel, the four combs side by side. Within a
+// run the positions, damping states and peak stay in locals, since a
+// store through any of the line buffers could otherwise alias them.
+static void comb_bank_scalar(reverb_node *node, int ch, const float *pIn,
+                             float *pOut, ma_uint32 frameCount, float *pPeak)
 {
-    float output = delay_line_read(dl);
-    // Low-pass filter on feedback for damping (high freq decay faster)
-    *damp_prev = output * (1.0f - damp) + (*damp_prev) * damp;
-    delay_line_write(dl, input + feedback * (*damp_prev));
-    return output;
+    delay_line *lines = node->combs[ch];
+    const float damp = node->params.comb_damp;
+    const float undamp = 1.0f - damp;
+    const float feedback = node->params.comb_feedback;
+    float s0 = node->comb_damp_prev[ch][0], s1 = node->comb_damp_prev[ch][1];
+    float s2 = node->comb_damp_prev[ch][2], s3 = node->comb_damp_prev[ch][3];
+    float peak = *pPeak;
+    ma_uint32 done = 0;
+
+    while (done < frameCount) {
+        ma_uint32 run = lines_run(lines, NUM_COMBS, frameCount - done);
+        float *p0 = lines[0].buffer + lines[0].pos;
+        float *p1 = lines[1].buffer + lines[1].pos;
+        float *p2 = lines[2].buffer + lines[2].pos;
+        float *p3 = lines[3].buffer + lines[3].pos;
+        const float *in = pIn + done;
+        float *out = pOut + done;
+
+        for (ma_uint32 k = 0; k < run; k++) {
+            float r0 = p0[k], r1 = p1[k], r2 = p2[k], r3 = p3[k];
+            float x = in[k];
+
+            s0 = r0 * undamp + s0 * damp;
+            s1 = r1 * undamp + s1 * damp;
+            s2 = r2 * undamp + s2 * damp;
+            s3 = r3 * undamp + s3 * damp;
+            float w0 = x + feedback * s0, w1 = x + feedback * s1;
+            float w2 = x + feedback * s2, w3 = x + feedback * s3;
+            p0[k] = w0;
+            p1[k] = w1;
+            p2[k] = w2;
+            p3[k] = w3;
+
+            if (fabsf(w0) > peak) peak = fabsf(w0);
+            if (fabsf(w1) > peak) peak = fabsf(w1);
+            if (fabsf(w2) > peak) peak = fabsf(w2);
+            if (fabsf(w3) > peak) peak = fabsf(w3);
+            out[k] = (((r0 + r1) + r2) + r3) * 0.25f;  // Average the 4 combs
+        }
+
+        lines_advance(lines, NUM_COMBS, run);
+        done += run;
+    }
+
+    node->comb_damp_prev[ch][0] = s0;
+    node->comb_damp_prev[ch][1] = s1;
+    node->comb_damp_prev[ch][2] = s2;
+    node->comb_damp_prev[ch][3] = s3;
+    *pPeak = peak;
 }
 
-// Allpass filter: output = -g*input + buffer[pos], write input + g*buffer[pos]
-static inline float allpass_process(delay_line *dl, float input, float feedback)
+#ifdef SIMD_SSE2
+static void comb_bank_sse2(reverb_node *node, int ch, const float *pIn,
+                           float *pOut, ma_uint32 frameCount, float *pPeak)
 {
-    float buffered = delay_line_read(dl);
-    float output = buffered - feedback * input;
-    delay_line_write(dl, input + feedback * buffered);
-    return output;
+    delay_line *lines = node->combs[ch];
+    __m128 damp = _mm_set1_ps(node->params.comb_damp);
+    __m128 undamp = _mm_set1_ps(1.0f - node->params.comb_damp);
+    __m128 feedback = _mm_set1_ps(node->params.comb_feedback);
+    __m128 quarter = _mm_set1_ps(0.25f);
+    __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 state = _mm_loadu_ps(node->comb_damp_prev[ch]);
+    __m128 peak = _mm_setzero_ps();
+    ma_uint32 done = 0;
+
+    while (done < frameCount) {
+        ma_uint32 run = lines_run(lines, NUM_COMBS, frameCount - done);
+        float *p0 = lines[0].buffer + lines[0].pos;
+        float *p1 = lines[1].buffer + lines[1].pos;
+        float *p2 = lines[2].buffer + lines[2].pos;
+        float *p3 = lines[3].buffer + lines[3].pos;
+        const float *in = pIn + done;
+        float *out = pOut + done;
+        ma_uint32 k = 0;
+
+        for (; k + 4 <= run; k += 4) {
+            __m128 r0 = _mm_loadu_ps(p0 + k), r1 = _mm_loadu_ps(p1 + k);
+            __m128 r2 = _mm_loadu_ps(p2 + k), r3 = _mm_loadu_ps(p3 + k);
+            _mm_storeu_ps(out + k, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), r2), r3), quarter));
+
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);  // r<n> = frame k+n of combs 0-3
+
+            state = _mm_add_ps(_mm_mul_ps(r0, undamp), _mm_mul_ps(state, damp));
+            __m128 w0 = _mm_add_ps(_mm_set1_ps(in[k]), _mm_mul_ps(feedback, state));
+            state = _mm_add_ps(_mm_mul_ps(r1, undamp), _mm_mul_ps(state, damp));
+            __m128 w1 = _mm_add_ps(_mm_set1_ps(in[k + 1]), _mm_mul_ps(feedback, state));
+            state = _mm_add_ps(_mm_mul_ps(r2, undamp), _mm_mul_ps(state, damp));
+            __m128 w2 = _mm_add_ps(_mm_set1_ps(in[k + 2]), _mm_mul_ps(feedback, state));
+            state = _mm_add_ps(_mm_mul_ps(r3, undamp), _mm_mul_ps(state, damp));
+            __m128 w3 = _mm_add_ps(_mm_set1_ps(in[k + 3]), _mm_mul_ps(feedback, state));
+
+            peak = _mm_max_ps(peak, _mm_max_ps(_mm_max_ps(_mm_and_ps(w0, absMask), _mm_and_ps(w1, absMask)),
+                                               _mm_max_ps(_mm_and_ps(w2, absMask), _mm_and_ps(w3, absMask))));
+
+            _MM_TRANSPOSE4_PS(w0, w1, w2, w3);  // Back to four frames per comb
+            _mm_storeu_ps(p0 + k, w0);
+            _mm_storeu_ps(p1 + k, w1);
+            _mm_storeu_ps(p2 + k, w2);
+            _mm_storeu_ps(p3 + k, w3);
+        }
+
+        for (; k < run; k++) {
+            __m128 r = _mm_setr_ps(p0[k], p1[k], p2[k], p3[k]);
+            out[k] = (((p0[k] + p1[k]) + p2[k]) + p3[k]) * 0.25f;
+
+            state = _mm_add_ps(_mm_mul_ps(r, undamp), _mm_mul_ps(state, damp));
+            __m128 w = _mm_add_ps(_mm_set1_ps(in[k]), _mm_mul_ps(feedback, state));
+            peak = _mm_max_ps(peak, _mm_and_ps(w, absMask));
+
+            float written[4];
+            _mm_storeu_ps(written, w);
+            p0[k] = written[0];
+            p1[k] = written[1];
+            p2[k] = written[2];
+            p3[k] = written[3];
+        }
+
+        lines_advance(lines, NUM_COMBS, run);
+        done += run;
+    }
+
+    _mm_storeu_ps(node->comb_damp_prev[ch], state);
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, peak);
+    for (int c = 0; c < 4; c++) {
+        if (lanes[c] > *pPeak) *pPeak = lanes[c];
+    }
+}
+#endif
+
+#ifdef SIMD_AVX
+// Both channels at once: lanes 0-3 are the left combs, 4-7 the right
+SIMD_TARGET_AVX
+static void comb_bank_avx(reverb_node *node, const float *pInL, const float *pInR,
+                          float *pOutL, float *pOutR, ma_uint32 frameCount, float *pPeak)
+{
+    delay_line *lines = &node->combs[0][0];  // [2][NUM_COMBS] is contiguous
+    __m256 damp = _mm256_set1_ps(node->params.comb_damp);
+    __m256 undamp = _mm256_set1_ps(1.0f - node->params.comb_damp);
+    __m256 feedback = _mm256_set1_ps(node->params.comb_feedback);
+    __m128 quarter = _mm_set1_ps(0.25f);
+    __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 state = _mm256_loadu_ps(&node->comb_damp_prev[0][0]);
+    __m256 peak = _mm256_setzero_ps();
+    ma_uint32 done = 0;
+
+    while (done < frameCount) {
+        ma_uint32 run = lines_run(lines, 2 * NUM_COMBS, frameCount - done);
+        float *p[8];
+        for (int c = 0; c < 8; c++) p[c] = lines[c].buffer + lines[c].pos;
+        const float *inL = pInL + done;
+        const float *inR = pInR + done;
+        ma_uint32 k = 0;
+
+        for (; k + 4 <= run; k += 4) {
+            __m128 l0 = _mm_loadu_ps(p[0] + k), l1 = _mm_loadu_ps(p[1] + k);
+            __m128 l2 = _mm_loadu_ps(p[2] + k), l3 = _mm_loadu_ps(p[3] + k);
+            __m128 r0 = _mm_loadu_ps(p[4] + k), r1 = _mm_loadu_ps(p[5] + k);
+            __m128 r2 = _mm_loadu_ps(p[6] + k), r3 = _mm_loadu_ps(p[7] + k);
+            _mm_storeu_ps(pOutL + done + k, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(l0, l1), l2), l3), quarter));
+            _mm_storeu_ps(pOutR + done + k, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), r2), r3), quarter));
+
+            _MM_TRANSPOSE4_PS(l0, l1, l2, l3);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            __m256 w[4];
+            __m128 lf[4] = { l0, l1, l2, l3 };
+            __m128 rf[4] = { r0, r1, r2, r3 };
+            for (int n = 0; n < 4; n++) {
+                __m256 read = _mm256_insertf128_ps(_mm256_castps128_ps256(lf[n]), rf[n], 1);
+                __m256 input = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(inL[k + n])),
+                                                    _mm_set1_ps(inR[k + n]), 1);
+                state = _mm256_add_ps(_mm256_mul_ps(read, undamp), _mm256_mul_ps(state, damp));
+                w[n] = _mm256_add_ps(input, _mm256_mul_ps(feedback, state));
+                peak = _mm256_max_ps(peak, _mm256_and_ps(w[n], absMask));
+            }
+
+            __m128 wl0 = _mm256_castps256_ps128(w[0]), wl1 = _mm256_castps256_ps128(w[1]);
+            __m128 wl2 = _mm256_castps256_ps128(w[2]), wl3 = _mm256_castps256_ps128(w[3]);
+            __m128 wr0 = _mm256_extractf128_ps(w[0], 1), wr1 = _mm256_extractf128_ps(w[1], 1);
+            __m128 wr2 = _mm256_extractf128_ps(w[2], 1), wr3 = _mm256_extractf128_ps(w[3], 1);
+            _MM_TRANSPOSE4_PS(wl0, wl1, wl2, wl3);
+            _MM_TRANSPOSE4_PS(wr0, wr1, wr2, wr3);
+            _mm_storeu_ps(p[0] + k, wl0);
+            _mm_storeu_ps(p[1] + k, wl1);
+            _mm_storeu_ps(p[2] + k, wl2);
+            _mm_storeu_ps(p[3] + k, wl3);
+            _mm_storeu_ps(p[4] + k, wr0);
+            _mm_storeu_ps(p[5] + k, wr1);
+            _mm_storeu_ps(p[6] + k, wr2);
+            _mm_storeu_ps(p[7] + k, wr3);
+        }
+
+        for (; k < run; k++) {
+            float read[8], written[8];
+            for (int c = 0; c < 8; c++) read[c] = p[c][k];
+            pOutL[done + k] = (((read[0] + read[1]) + read[2]) + read[3]) * 0.25f;
+            pOutR[done + k] = (((read[4] + read[5]) + read[6]) + read[7]) * 0.25f;
+
+            __m256 input = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(inL[k])),
+                                                _mm_set1_ps(inR[k]), 1);
+            state = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(read), undamp), _mm256_mul_ps(state, damp));
+            __m256 w = _mm256_add_ps(input, _mm256_mul_ps(feedback, state));
+            peak = _mm256_max_ps(peak, _mm256_and_ps(w, absMask));
+
+            _mm256_storeu_ps(written, w);
+            for (int c = 0; c < 8; c++) p[c][k] = written[c];
+        }
+
+        lines_advance(lines, 2 * NUM_COMBS, run);
+        done += run;
+    }
+
+    _mm256_storeu_ps(&node->comb_damp_prev[0][0], state);
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, peak);
+    for (int c = 0; c < 8; c++) {
+        if (lanes[c] > *pPeak) *pPeak = lanes[c];
+    }
+}
+#endif
+
+#ifdef SIMD_NEON
+static inline void transpose4_neon(float32x4_t *r0, float32x4_t *r1, float32x4_t *r2, float32x4_t *r3)
+{
+    float32x4x2_t t01 = vtrnq_f32(*r0, *r1);
+    float32x4x2_t t23 = vtrnq_f32(*r2, *r3);
+    *r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    *r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    *r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    *r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+static void comb_bank_neon(reverb_node *node, int ch, const float *pIn,
+                           float *pOut, ma_uint32 frameCount, float *pPeak)
+{
+    delay_line *lines = node->combs[ch];
+    float32x4_t damp = vdupq_n_f32(node->params.comb_damp);
+    float32x4_t undamp = vdupq_n_f32(1.0f - node->params.comb_damp);
+    float32x4_t feedback = vdupq_n_f32(node->params.comb_feedback);
+    float32x4_t quarter = vdupq_n_f32(0.25f);
+    float32x4_t state = vld1q_f32(node->comb_damp_prev[ch]);
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    ma_uint32 done = 0;
+
+    while (done < frameCount) {
+        ma_uint32 run = lines_run(lines, NUM_COMBS, frameCount - done);
+        float *p0 = lines[0].buffer + lines[0].pos;
+        float *p1 = lines[1].buffer + lines[1].pos;
+        float *p2 = lines[2].buffer + lines[2].pos;
+        float *p3 = lines[3].buffer + lines[3].pos;
+        const float *in = pIn + done;
+        float *out = pOut + done;
+        ma_uint32 k = 0;
+
+        for (; k + 4 <= run; k += 4) {
+            float32x4_t r0 = vld1q_f32(p0 + k), r1 = vld1q_f32(p1 + k);
+            float32x4_t r2 = vld1q_f32(p2 + k), r3 = vld1q_f32(p3 + k);
+            vst1q_f32(out + k, vmulq_f32(vaddq_f32(vaddq_f32(vaddq_f32(r0, r1), r2), r3), quarter));
+
+            transpose4_neon(&r0, &r1, &r2, &r3);  // r<n> = frame k+n of combs 0-3
+
+            state = vaddq_f32(vmulq_f32(r0, undamp), vmulq_f32(state, damp));
+            float32x4_t w0 = vaddq_f32(vdupq_n_f32(in[k]), vmulq_f32(feedback, state));
+            state = vaddq_f32(vmulq_f32(r1, undamp), vmulq_f32(state, damp));
+            float32x4_t w1 = vaddq_f32(vdupq_n_f32(in[k + 1]), vmulq_f32(feedback, state));
+            state = vaddq_f32(vmulq_f32(r2, undamp), vmulq_f32(state, damp));
+            float32x4_t w2 = vaddq_f32(vdupq_n_f32(in[k + 2]), vmulq_f32(feedback, state));
+            state = vaddq_f32(vmulq_f32(r3, undamp), vmulq_f32(state, damp));
+            float32x4_t w3 = vaddq_f32(vdupq_n_f32(in[k + 3]), vmulq_f32(feedback, state));
+
+            peak = vmaxq_f32(peak, vmaxq_f32(vmaxq_f32(vabsq_f32(w0), vabsq_f32(w1)),
+                                             vmaxq_f32(vabsq_f32(w2), vabsq_f32(w3))));
+
+            transpose4_neon(&w0, &w1, &w2, &w3);  // Back to four frames per comb
+            vst1q_f32(p0 + k, w0);
+            vst1q_f32(p1 + k, w1);
+            vst1q_f32(p2 + k, w2);
+            vst1q_f32(p3 + k, w3);
+        }
+
+        for (; k < run; k++) {
+            float read[4] = { p0[k], p1[k], p2[k], p3[k] };
+            out[k] = (((read[0] + read[1]) + read[2]) + read[3]) * 0.25f;
+
+            state = vaddq_f32(vmulq_f32(vld1q_f32(read), undamp), vmulq_f32(state, damp));
+            float32x4_t w = vaddq_f32(vdupq_n_f32(in[k]), vmulq_f32(feedback, state));
+            peak = vmaxq_f32(peak, vabsq_f32(w));
+
+            float written[4];
+            vst1q_f32(written, w);
+            p0[k] = written[0];
+            p1[k] = written[1];
+            p2[k] = written[2];
+            p3[k] = written[3];
+        }
+
+        lines_advance(lines, NUM_COMBS, run);
+        done += run;
+    }
+
+    vst1q_f32(node->comb_damp_prev[ch], state);
+
+    float lanes[4];
+    vst1q_f32(lanes, peak);
+    for (int c = 0; c < 4; c++) {
+        if (lanes[c] > *pPeak) *pPeak = lanes[c];
+    }
+}
+#endif
+
+static void comb_bank(reverb_node *node, ma_uint32 chans, float input[2][REVERB_BLOCK_FRAMES],
+                      float combOut[2][REVERB_BLOCK_FRAMES], ma_uint32 frameCount, float *pPeak)
+{
+    simd_backend backend = simd_get_backend();
+
+#ifdef SIMD_AVX
+    if (backend == SIMD_BACKEND_AVX && chans == 2) {
+        comb_bank_avx(node, input[0], input[1], combOut[0], combOut[1], frameCount, pPeak);
+        return;
+    }
+#endif
+
+    for (ma_uint32 ch = 0; ch < chans; ch++) {
+#if defined(SIMD_SSE2)
+        if (backend != SIMD_BACKEND_SCALAR) {
+            comb_bank_sse2(node, (int)ch, input[ch], combOut[ch], frameCount, pPeak);
+            continue;
+        }
+#elif defined(SIMD_NEON)
+        if (backend != SIMD_BACKEND_SCALAR) {
+            comb_bank_neon(node, (int)ch, input[ch], combOut[ch], frameCount, pPeak);
+            continue;
+        }
+#endif
+        comb_bank_scalar(node, (int)ch, input[ch], combOut[ch], frameCount, pPeak);
+    }
+}
+
+// Runs a block through one allpass in place. Like the combs, a run that
+// doesn't wrap never reads a slot it has already written, so the frames of
+// a run are independent and vectorize across time.
+static void allpass_block(delay_line *dl, float *pSamples, ma_uint32 frameCount,
+                          float feedback, float *pPeak)
+{
+    ma_bool32 vector = simd_get_backend() != SIMD_BACKEND_SCALAR;
+    float peak = *pPeak;
+    ma_uint32 done = 0;
+
+    (void)vector;
+
+    while (done < frameCount) {
+        ma_uint32 run = lines_run(dl, 1, frameCount - done);
+        float *buf = dl->buffer + dl->pos;
+        float *x = pSamples + done;
+        ma_uint32 k = 0;
+
+#if defined(SIMD_SSE2)
+        if (vector) {
+            __m128 g = _mm_set1_ps(feedback);
+            __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            __m128 vpeak = _mm_set1_ps(peak);
+            for (; k + 4 <= run; k += 4) {
+                __m128 buffered = _mm_loadu_ps(buf + k);
+                __m128 in = _mm_loadu_ps(x + k);
+                __m128 written = _mm_add_ps(in, _mm_mul_ps(g, buffered));
+                _mm_storeu_ps(x + k, _mm_sub_ps(buffered, _mm_mul_ps(g, in)));
+                _mm_storeu_ps(buf + k, written);
+                vpeak = _mm_max_ps(vpeak, _mm_and_ps(written, absMask));
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, vpeak);
+            for (int i = 0; i < 4; i++) {
+                if (lanes[i] > peak) peak = lanes[i];
+            }
+        }
+#elif defined(SIMD_NEON)
+        if (vector) {
+            float32x4_t g = vdupq_n_f32(feedback);
+            float32x4_t vpeak = vdupq_n_f32(peak);
+            for (; k + 4 <= run; k += 4) {
+                float32x4_t buffered = vld1q_f32(buf + k);
+                float32x4_t in = vld1q_f32(x + k);
+                float32x4_t written = vaddq_f32(in, vmulq_f32(g, buffered));
+                vst1q_f32(x + k, vsubq_f32(buffered, vmulq_f32(g, in)));
+                vst1q_f32(buf + k, written);
+                vpeak = vmaxq_f32(vpeak, vabsq_f32(written));
+            }
+            float lanes[4];
+            vst1q_f32(lanes, vpeak);
+            for (int i = 0; i < 4; i++) {
+                if (lanes[i] > peak) peak = lanes[i];
+            }
+        }
+#endif
+
+        for (; k < run; k++) {
+            float buffered = buf[k];
+            float written = x[k] + feedback * buffered;
+            x[k] = buffered - feedback * x[k];
+            buf[k] = written;
+            if (fabsf(written) > peak) peak = fabsf(written);
+        }
+
+        lines_advance(dl, 1, run);
+        done += run;
+    }
+
+    *pPeak = peak;
 }
 
 // ============================================================================
-// DSP Callback
+// Commands
 // ============================================================================
 
-static void reverb_process(ma_node *pNode, const float **ppFramesIn,
-                           ma_uint32 *pFrameCountIn, float **ppFramesOut,
-                           ma_uint32 *pFrameCountOut)
+enum {
+    REVERB_CMD_ENABLED,     // frames holds the flag
+    REVERB_CMD_FEEDBACK,
+    REVERB_CMD_DAMPING,
+    REVERB_CMD_WET,         // Wet and dry ramp over frames, index holds the curve
+    REVERB_CMD_DRY
+};
+
+// Render side: picks up every change posted since the last block. A
+// snapshot is older than anything queued after its queue_tail, so it
+// goes first.
+static void reverb_apply_commands(reverb_node *node)
 {
-    reverb_node *node = (reverb_node *)pNode;
-    const float *pFramesIn = ppFramesIn[0];
-    float *pFramesOut = ppFramesOut[0];
-    ma_uint32 frameCount = *pFrameCountOut;
-    ma_uint32 numChannels = node->channels;
+    param_command command;
+
+    if (spsc_triple_take(&node->snapshot_slots)) {
+        const reverb_snapshot *snapshot = &node->snapshots[node->snapshot_slots.front];
+        node->params = snapshot->params;
+        param_ramp_set(&node->wet_ramp, node->params.wet);
+        param_ramp_set(&node->dry_ramp, node->params.dry);
+        param_queue_skip_to(&node->commands, snapshot->queue_tail);
+    }
 
-    if (!node->enabled) {
-        // Bypass: copy input to output
-        memcpy(pFramesOut, pFramesIn, frameCount * numChannels * sizeof(float));
+    while (param_queue_pop(&node->commands, &command)) {
+        switch (command.op) {
+            case REVERB_CMD_ENABLED:  node->params.enabled = command.frames; break;
+            case REVERB_CMD_FEEDBACK: node->params.comb_feedback = command.value; break;
+            case REVERB_CMD_DAMPING:  node->params.comb_damp = command.value; break;
+            case REVERB_CMD_WET:
+                node->params.wet = command.value;
+                param_ramp_start(&node->wet_ramp, command.value, command.frames, (ramp_curve)command.index);
+                break;
+            case REVERB_CMD_DRY:
+                node->params.dry = command.value;
+                param_ramp_start(&node->dry_ramp, command.value, command.frames, (ramp_curve)command.index);
+                break;
+        }
+    }
+}
+
+// ============================================================================
+// DSP Kernel
+// ============================================================================
+
+void reverb_render(reverb_node *node, const float *pFramesIn, float *pFramesOut, ma_uint32 frameCount)
+{
+    reverb_apply_commands(node);
+
+    ma_uint32 numChannels = node->channels;
+    ma_uint32 chans = numChannels < 2 ? numChannels : 2;
+    float writePeak = 0.0f;
+
+    // Disabled, the lines take no more input but ring out what they hold
+    ma_bool32 feeding = node->params.enabled;
+    ma_bool32 ringing = node->quiet_frames < node->longest_line;
+
+    if (!ringing && (pFramesIn == NULL || !feeding)) {
+        if (pFramesIn == NULL) {
+            // Nothing coming in and nothing left ringing (idle bus)
+            memset(pFramesOut, 0, frameCount * numChannels * sizeof(float));
+            if (node->quiet_frames < node->longest_line * 2) {
+                node->quiet_frames += frameCount;
+            }
+        } else {
+            // Bypass: copy input to output
+            memcpy(pFramesOut, pFramesIn, frameCount * numChannels * sizeof(float));
+        }
+        param_ramp_skip(&node->wet_ramp, frameCount);
+        param_ramp_skip(&node->dry_ramp, frameCount);
         return;
     }
 
-    for (ma_uint32 iFrame = 0; iFrame < frameCount; iFrame++) {
-        for (ma_uint32 iChannel = 0; iChannel < numChannels && iChannel < 2; iChannel++) {
-            ma_uint32 sampleIndex = iFrame * numChannels + iChannel;
-            float input = pFramesIn[sampleIndex];
+    ma_uint32 totalFrames = frameCount;
+    float input[2][REVERB_BLOCK_FRAMES];
+    float combOut[2][REVERB_BLOCK_FRAMES];
 
-            // Sum of parallel comb filters
-            float combSum = 0.0f;
-            for (int c = 0; c < NUM_COMBS; c++) {
-                combSum += comb_process(&node->combs[iChannel][c], input,
-                                        node->comb_feedback, node->comb_damp,
-                                        &node->comb_damp_prev[iChannel][c]);
+    while (frameCount > 0) {
+        ma_uint32 blockFrames = (frameCount < REVERB_BLOCK_FRAMES) ? frameCount : REVERB_BLOCK_FRAMES;
+
+        // De-interleave so each channel's combs see a contiguous input
+        for (ma_uint32 ch = 0; ch < chans; ch++) {
+            if (pFramesIn == NULL || !feeding) {
+                memset(input[ch], 0, blockFrames * sizeof(float));
+                continue;
             }
-            combSum *= 0.25f;  // Average the 4 combs
+            for (ma_uint32 iFrame = 0; iFrame < blockFrames; iFrame++) {
+                input[ch][iFrame] = pFramesIn[iFrame * numChannels + ch];
+            }
+        }
+
+        // Sum of parallel comb filters
+        comb_bank(node, chans, input, combOut, blockFrames, &writePeak);
 
-            // Series allpass filters
-            float allpassOut = combSum;
+        // Series allpass filters
+        for (ma_uint32 ch = 0; ch < chans; ch++) {
             for (int a = 0; a < NUM_ALLPASSES; a++) {
-                allpassOut = allpass_process(&node->allpasses[iChannel][a],
-                                             allpassOut, node->allpass_feedback);
+                allpass_block(&node->allpasses[ch][a], combOut[ch], blockFrames,
+                              node->allpass_feedback, &writePeak);
             }
-
-            // Mix dry and wet
-            pFramesOut[sampleIndex] = input * node->dry + allpassOut * node->wet;
         }
 
-        // Handle mono->stereo or more channels by copying
-        for (ma_uint32 iChannel = 2; iChannel < numChannels; iChannel++) {
-            ma_uint32 sampleIndex = iFrame * numChannels + iChannel;
-            pFramesOut[sampleIndex] = pFramesIn[sampleIndex];
+        // Mix dry and wet. Ringing out, the input passes as in bypass.
+        if (feeding && numChannels == 2 && !param_ramp_active(&node->dry_ramp) && !param_ramp_active(&node->wet_ramp)) {
+            float dry = node->dry_ramp.value;
+            float wet = node->wet_ramp.value;
+            for (ma_uint32 iFrame = 0; iFrame < blockFrames; iFrame++) {
+                pFramesOut[iFrame * 2 + 0] = input[0][iFrame] * dry + combOut[0][iFrame] * wet;
+                pFramesOut[iFrame * 2 + 1] = input[1][iFrame] * dry + combOut[1][iFrame] * wet;
+            }
+        } else {
+            for (ma_uint32 iFrame = 0; iFrame < blockFrames; iFrame++) {
+                float dry = param_ramp_next(&node->dry_ramp);
+                float wet = param_ramp_next(&node->wet_ramp);
+                for (ma_uint32 ch = 0; ch < chans; ch++) {
+                    float in = feeding ? input[ch][iFrame] * dry
+                                       : ((pFramesIn != NULL) ? pFramesIn[iFrame * numChannels + ch] : 0.0f);
+                    pFramesOut[iFrame * numChannels + ch] = in + combOut[ch][iFrame] * wet;
+                }
+
+                // Handle mono->stereo or more channels by copying
+                for (ma_uint32 ch = 2; ch < numChannels; ch++) {
+                    ma_uint32 sampleIndex = iFrame * numChannels + ch;
+                    pFramesOut[sampleIndex] = (pFramesIn != NULL) ? pFramesIn[sampleIndex] : 0.0f;
+                }
+            }
         }
+
+        if (pFramesIn != NULL) pFramesIn += blockFrames * numChannels;
+        pFramesOut += blockFrames * numChannels;
+        frameCount -= blockFrames;
+    }
+
+    // Once every line has been rewritten with near-silence the tail is over
+    if (writePeak > REVERB_SILENCE_THRESHOLD) {
+        node->quiet_frames = 0;
+    } else if (node->quiet_frames < node->longest_line * 2) {
+        node->quiet_frames += totalFrames;
     }
 }
 
+// ============================================================================
+// DSP Callback
+// ============================================================================
+
+static void reverb_process(ma_node *pNode, const float **ppFramesIn,
+                           ma_uint32 *pFrameCountIn, float **ppFramesOut,
+                           ma_uint32 *pFrameCountOut)
+{
+    const float *pFramesIn = (ppFramesIn != NULL) ? ppFramesIn[0] : NULL;  // NULL once the source stops
+
+    reverb_render((reverb_node *)pNode, pFramesIn, ppFramesOut[0], *pFrameCountOut);
+}
+
 static ma_node_vtable g_reverb_vtable = {
     reverb_process,
     NULL,
     1,
     1,
-    0
+    MA_NODE_FLAG_CONTINUOUS_PROCESSING | MA_NODE_FLAG_ALLOW_NULL_INPUT  // Keep running for the tail
 };
 
 // ============================================================================
 // Lifecycle
 // ============================================================================
 
+static void reverb_set_defaults(reverb_node *pNode)
+{
+    pNode->control.enabled = MA_FALSE;
+    pNode->control.room_size = 0.5f;
+    pNode->control.comb_feedback = 0.7f;
+    pNode->control.comb_damp = 0.3f;
+    pNode->control.wet = 0.3f;
+    pNode->control.dry = 1.0f;
+    pNode->params = pNode->control;
+    param_ramp_set(&pNode->wet_ramp, pNode->params.wet);
+    param_ramp_set(&pNode->dry_ramp, pNode->params.dry);
+    pNode->allpass_feedback = 0.5f;
+
+    param_queue_init(&pNode->commands);
+    spsc_triple_init(&pNode->snapshot_slots);
+    pNode->snapshotting = MA_FALSE;
+}
+
 ma_result reverb_init(reverb_node *pNode, ma_node_graph *pNodeGraph,
                       ma_uint32 sampleRate, ma_uint32 numChannels)
 {
@@ -139,28 +685,22 @@ ma_result reverb_init(reverb_node *pNode, ma_node_graph *pNodeGraph,
     memset(pNode, 0, sizeof(*pNode));
     pNode->sample_rate = sampleRate;
     pNode->channels = numChannels;
-    pNode->enabled = MA_FALSE;
-
-    // Default parameters
-    pNode->room_size = 0.5f;
-    pNode->comb_feedback = 0.7f;
-    pNode->comb_damp = 0.3f;
-    pNode->allpass_feedback = 0.5f;
-    pNode->wet = 0.3f;
-    pNode->dry = 1.0f;
+    reverb_set_defaults(pNode);
 
     // Initialize delay lines for up to 2 audio channels
     ma_uint32 chans = numChannels < 2 ? numChannels : 2;
     for (ma_uint32 ch = 0; ch < chans; ch++) {
         for (int c = 0; c < NUM_COMBS; c++) {
-            ma_uint32 delaySize = (ma_uint32)(COMB_DELAYS[c] * pNode->room_size * 2.0f * sampleRate);
+            ma_uint32 delaySize = (ma_uint32)(COMB_DELAYS[c] * pNode->control.room_size * 2.0f * sampleRate);
             if (delaySize < 1) delaySize = 1;
             delay_line_init(&pNode->combs[ch][c], delaySize);
+            if (delaySize > pNode->longest_line) pNode->longest_line = delaySize;
         }
         for (int a = 0; a < NUM_ALLPASSES; a++) {
             ma_uint32 delaySize = (ma_uint32)(ALLPASS_DELAYS[a] * sampleRate);
             if (delaySize < 1) delaySize = 1;
             delay_line_init(&pNode->allpasses[ch][a], delaySize);
+            if (delaySize > pNode->longest_line) pNode->longest_line = delaySize;
         }
     }
 
@@ -190,35 +730,155 @@ void reverb_uninit(reverb_node *pNode)
     }
 }
 
+void reverb_reset(reverb_node *pNode)
+{
+    if (pNode == NULL) return;
+
+    // Delay lines are only written while enabled, so skip the clear if never used
+    if (pNode->dirty) {
+        for (int ch = 0; ch < 2; ch++) {
+            for (int c = 0; c < NUM_COMBS; c++) {
+                delay_line_clear(&pNode->combs[ch][c]);
+                pNode->comb_damp_prev[ch][c] = 0.0f;
+            }
+            for (int a = 0; a < NUM_ALLPASSES; a++) {
+                delay_line_clear(&pNode->allpasses[ch][a]);
+            }
+        }
+        pNode->dirty = MA_FALSE;
+        pNode->quiet_frames = 0;
+    }
+
+    reverb_set_defaults(pNode);
+}
+
+// ============================================================================
+// Tail Tracking
+// ============================================================================
+
+// Analytical bound: frames for the combs to decay from full scale to the
+// silence threshold (an RT60 stretched to -80 dB), plus the allpass chain
+ma_uint32 reverb_tail_frames(reverb_node *pNode)
+{
+    if (pNode == NULL || !pNode->dirty) {
+        return 0;
+    }
+
+    float feedback = pNode->control.comb_feedback;
+    if (feedback <= 0.0f) {
+        return pNode->longest_line;
+    }
+    if (feedback >= 1.0f) {
+        return 0xFFFFFFFF;
+    }
+
+    float passes = logf(REVERB_SILENCE_THRESHOLD) / logf(feedback);
+    float frames = passes * (float)pNode->longest_line + (float)pNode->longest_line;
+    return frames >= 4294967040.0f ? 0xFFFFFFFF : (ma_uint32)frames;
+}
+
+// True once every delay line has been rewritten with near-silence. A
+// disabled node rings out what it holds, so it counts too until then.
+ma_bool32 reverb_is_silent(reverb_node *pNode)
+{
+    if (pNode == NULL || !pNode->dirty) {
+        return MA_TRUE;
+    }
+
+    return pNode->quiet_frames >= pNode->longest_line;
+}
+
 // ============================================================================
 // Parameter Control
 // ============================================================================
 
+// Called from the Ruby thread. Each change lands in control and is posted
+// to the render.
+
+// While the render is behind (the queue filled up), every change
+// publishes the whole parameter set instead; single commands resume once
+// the render has taken the latest set.
+static void reverb_post(reverb_node *pNode, ma_uint32 op, ma_uint32 frames, ramp_curve curve)
+{
+    if (pNode->snapshotting && !spsc_triple_pending(&pNode->snapshot_slots)) {
+        pNode->snapshotting = MA_FALSE;
+    }
+
+    if (!pNode->snapshotting) {
+        param_command command = { op, (ma_uint32)curve, frames, 0.0f };
+
+        switch (op) {
+            case REVERB_CMD_ENABLED:  command.frames = pNode->control.enabled; break;
+            case REVERB_CMD_FEEDBACK: command.value = pNode->control.comb_feedback; break;
+            case REVERB_CMD_DAMPING:  command.value = pNode->control.comb_damp; break;
+            case REVERB_CMD_WET:      command.value = pNode->control.wet; break;
+            case REVERB_CMD_DRY:      command.value = pNode->control.dry; break;
+        }
+
+        if (param_queue_push(&pNode->commands, &command)) {
+            return;
+        }
+        pNode->snapshotting = MA_TRUE;
+    }
+
+    reverb_snapshot *snapshot = &pNode->snapshots[pNode->snapshot_slots.back];
+    snapshot->params = pNode->control;
+    snapshot->queue_tail = param_queue_tail(&pNode->commands);
+    spsc_triple_publish(&pNode->snapshot_slots);
+}
+
 void reverb_set_enabled(reverb_node *pNode, ma_bool32 enabled)
 {
-    if (pNode) pNode->enabled = enabled;
+    if (pNode == NULL) return;
+    pNode->control.enabled = enabled;
+    if (enabled) pNode->dirty = MA_TRUE;
+    reverb_post(pNode, REVERB_CMD_ENABLED, 0, RAMP_LINEAR);
+}
+
+ma_bool32 reverb_is_enabled(reverb_node *pNode)
+{
+    return pNode != NULL && pNode->control.enabled;
 }
 
 void reverb_set_room_size(reverb_node *pNode, float size)
 {
     if (pNode == NULL) return;
-    pNode->room_size = size;
+    pNode->control.room_size = size;
     // Note: changing room_size after init would require reallocating buffers
     // For now, this affects feedback calculation
-    pNode->comb_feedback = 0.6f + size * 0.35f;  // 0.6 to 0.95
+    pNode->control.comb_feedback = 0.6f + size * 0.35f;  // 0.6 to 0.95
+    reverb_post(pNode, REVERB_CMD_FEEDBACK, 0, RAMP_LINEAR);
 }
 
 void reverb_set_damping(reverb_node *pNode, float damp)
 {
-    if (pNode) pNode->comb_damp = damp;
+    if (pNode == NULL) return;
+    pNode->control.comb_damp = damp;
+    reverb_post(pNode, REVERB_CMD_DAMPING, 0, RAMP_LINEAR);
 }
 
 void reverb_set_wet(reverb_node *pNode, float wet)
 {
-    if (pNode) pNode->wet = wet;
+    reverb_ramp_wet(pNode, wet, 0, RAMP_LINEAR);
 }
 
 void reverb_set_dry(reverb_node *pNode, float dry)
 {
-    if (pNode) pNode->dry = dry;
+    reverb_ramp_dry(pNode, dry, 0, RAMP_LINEAR);
+}
+
+// The render heads for the new level one frame at a time, from wherever an
+// earlier ramp has got to
+void reverb_ramp_wet(reverb_node *pNode, float wet, ma_uint32 frames, ramp_curve curve)
+{
+    if (pNode == NULL) return;
+    pNode->control.wet = wet;
+    reverb_post(pNode, REVERB_CMD_WET, frames, curve);
+}
+
+void reverb_ramp_dry(reverb_node *pNode, float dry, ma_uint32 frames, ramp_curve curve)
+{
+    if (pNode == NULL) return;
+    pNode->control.dry = dry;
+    reverb_post(pNode, REVERB_CMD_DRY, frames, curve);
 }
@@ -6,6 +6,8 @@
 #define REVERB_NODE_H
 
 #include "miniaudio.h"
+#include "spsc_queue.h"
+#include "param_ramp.h"
 
 // ============================================================================
 // Constants
@@ -13,6 +15,8 @@
 
 #define NUM_COMBS 4
 #define NUM_ALLPASSES 2
+#define REVERB_BLOCK_FRAMES 256           // Frames per comb bank pass
+#define REVERB_SILENCE_THRESHOLD 0.0001f  // -80 dBFS
 
 // ============================================================================
 // Types
@@ -24,6 +28,23 @@ typedef struct {
     ma_uint32 pos;
 } delay_line;
 
+// Everything the Ruby thread can change
+typedef struct {
+    ma_bool32 enabled;
+    float room_size;
+    float comb_feedback;
+    float comb_damp;
+    float wet;
+    float dry;
+} reverb_params;
+
+// Every parameter, posted instead of single changes when the queue is
+// full. It supersedes every command before queue_tail.
+typedef struct {
+    reverb_params params;
+    ma_uint32 queue_tail;
+} reverb_snapshot;
+
 typedef struct {
     ma_node_base base;
     ma_uint32 channels;
@@ -31,19 +52,28 @@ typedef struct {
 
     // 4 parallel comb filters per audio channel
     delay_line combs[2][NUM_COMBS];  // [audio_channel][comb_index]
-    float comb_feedback;
-    float comb_damp;
     float comb_damp_prev[2][NUM_COMBS];
 
     // 2 series allpass filters per audio channel
     delay_line allpasses[2][NUM_ALLPASSES];
     float allpass_feedback;
 
-    // Mix control
-    float wet;
-    float dry;
-    float room_size;
-    ma_bool32 enabled;
+    // The Ruby thread sets control and posts each change; the render
+    // copies them into params between blocks. Wet and dry are mixed
+    // through ramps heading for params.wet and params.dry.
+    reverb_params params;
+    param_ramp wet_ramp;
+    param_ramp dry_ramp;
+    reverb_params control;
+    param_queue commands;
+    ma_bool32 snapshotting;  // A post didn't fit; whole sets go until one is taken
+    reverb_snapshot snapshots[3];
+    spsc_triple snapshot_slots;
+    ma_bool32 dirty;         // Delay lines hold state from a previous use
+
+    // Tail tracking
+    ma_uint32 longest_line;          // Frames for every delay line to be rewritten
+    volatile ma_uint32 quiet_frames; // Consecutive frames with every write below threshold
 } reverb_node;
 
 // ============================================================================
@@ -53,11 +83,19 @@ typedef struct {
 ma_result reverb_init(reverb_node *pNode, ma_node_graph *pNodeGraph,
                       ma_uint32 sampleRate, ma_uint32 numChannels);
 void reverb_uninit(reverb_node *pNode);
+void reverb_reset(reverb_node *pNode);     // Only while out of the graph
+void reverb_render(reverb_node *pNode, const float *pFramesIn, float *pFramesOut, ma_uint32 frameCount);
+
+ma_uint32 reverb_tail_frames(reverb_node *pNode);
+ma_bool32 reverb_is_silent(reverb_node *pNode);
 
 void reverb_set_enabled(reverb_node *pNode, ma_bool32 enabled);
+ma_bool32 reverb_is_enabled(reverb_node *pNode);
 void reverb_set_room_size(reverb_node *pNode, float size);
 void reverb_set_damping(reverb_node *pNode, float damp);
 void reverb_set_wet(reverb_node *pNode, float wet);
 void reverb_set_dry(reverb_node *pNode, float dry);
+void reverb_ramp_wet(reverb_node *pNode, float wet, ma_uint32 frames, ramp_curve curve);
+void reverb_ramp_dry(reverb_node *pNode, float dry, ma_uint32 frames, ramp_curve curve);
 
 #endif // REVERB_NODE_H
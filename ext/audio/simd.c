@@ -0,0 +1,183 @@
+// ============================================================================
+// simd.c - Vector kernels with runtime dispatch
+// ============================================================================
+
+#include <math.h>
+#include <stdlib.h>
+#include "simd.h"
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+static void mix_scaled_scalar(float *pDst, const float *pSrc, float gain, ma_uint32 count)
+{
+    for (ma_uint32 i = 0; i < count; i++) {
+        pDst[i] += pSrc[i] * gain;
+    }
+}
+
+// ============================================================================
+// SSE2
+// ============================================================================
+
+#ifdef SIMD_SSE2
+static void mix_scaled_sse2(float *pDst, const float *pSrc, float gain, ma_uint32 count)
+{
+    __m128 g = _mm_set1_ps(gain);
+    ma_uint32 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_add_ps(_mm_loadu_ps(pDst + i), _mm_mul_ps(_mm_loadu_ps(pSrc + i), g));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(pDst + i + 4), _mm_mul_ps(_mm_loadu_ps(pSrc + i + 4), g));
+        _mm_storeu_ps(pDst + i, a);
+        _mm_storeu_ps(pDst + i + 4, b);
+    }
+
+    for (; i < count; i++) {
+        pDst[i] += pSrc[i] * gain;
+    }
+}
+#endif
+
+// ============================================================================
+// AVX (compiled for the target, only called after a CPU check)
+// ============================================================================
+
+#ifdef SIMD_AVX
+SIMD_TARGET_AVX
+static void mix_scaled_avx(float *pDst, const float *pSrc, float gain, ma_uint32 count)
+{
+    __m256 g = _mm256_set1_ps(gain);
+    ma_uint32 i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_add_ps(_mm256_loadu_ps(pDst + i), _mm256_mul_ps(_mm256_loadu_ps(pSrc + i), g));
+        __m256 b = _mm256_add_ps(_mm256_loadu_ps(pDst + i + 8), _mm256_mul_ps(_mm256_loadu_ps(pSrc + i + 8), g));
+        _mm256_storeu_ps(pDst + i, a);
+        _mm256_storeu_ps(pDst + i + 8, b);
+    }
+
+    for (; i < count; i++) {
+        pDst[i] += pSrc[i] * gain;
+    }
+}
+#endif
+
+// ============================================================================
+// NEON
+// ============================================================================
+
+#ifdef SIMD_NEON
+static void mix_scaled_neon(float *pDst, const float *pSrc, float gain, ma_uint32 count)
+{
+    float32x4_t g = vdupq_n_f32(gain);
+    ma_uint32 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        vst1q_f32(pDst + i, vmlaq_f32(vld1q_f32(pDst + i), vld1q_f32(pSrc + i), g));
+        vst1q_f32(pDst + i + 4, vmlaq_f32(vld1q_f32(pDst + i + 4), vld1q_f32(pSrc + i + 4), g));
+    }
+
+    for (; i < count; i++) {
+        pDst[i] += pSrc[i] * gain;
+    }
+}
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+#if defined(SIMD_SSE2)
+simd_mix_scaled_proc simd_mix_scaled = mix_scaled_sse2;
+static simd_backend backend = SIMD_BACKEND_SSE2;
+#elif defined(SIMD_NEON)
+simd_mix_scaled_proc simd_mix_scaled = mix_scaled_neon;
+static simd_backend backend = SIMD_BACKEND_NEON;
+#else
+simd_mix_scaled_proc simd_mix_scaled = mix_scaled_scalar;
+static simd_backend backend = SIMD_BACKEND_SCALAR;
+#endif
+
+static simd_mix_scaled_proc best_mix_scaled;
+static simd_backend best_backend;
+
+void simd_init(void)
+{
+#ifdef SIMD_AVX
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx")) {
+        simd_mix_scaled = mix_scaled_avx;
+        backend = SIMD_BACKEND_AVX;
+    }
+#endif
+
+    // Forces the portable path, e.g. to rule out a vector kernel
+    if (getenv("NATIVE_AUDIO_NO_SIMD") != NULL) {
+        simd_mix_scaled = mix_scaled_scalar;
+        backend = SIMD_BACKEND_SCALAR;
+    }
+
+    best_mix_scaled = simd_mix_scaled;
+    best_backend = backend;
+}
+
+// Switches between the scalar kernels and the best available ones
+void simd_use_scalar(ma_bool32 scalar)
+{
+    if (best_mix_scaled == NULL) {
+        best_mix_scaled = simd_mix_scaled;
+        best_backend = backend;
+    }
+
+    simd_mix_scaled = scalar ? mix_scaled_scalar : best_mix_scaled;
+    backend = scalar ? SIMD_BACKEND_SCALAR : best_backend;
+}
+
+simd_backend simd_get_backend(void)
+{
+    return backend;
+}
+
+const char *simd_backend_name(void)
+{
+    switch (backend) {
+        case SIMD_BACKEND_SSE2: return "sse2";
+        case SIMD_BACKEND_AVX:  return "avx";
+        case SIMD_BACKEND_NEON: return "neon";
+        default:                return "scalar";
+    }
+}
+
+float simd_peak(const float *pSrc, ma_uint32 count)
+{
+    ma_uint32 i = 0;
+    float peak = 0.0f;
+
+#if defined(SIMD_SSE2)
+    __m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 m = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        m = _mm_max_ps(m, _mm_and_ps(_mm_loadu_ps(pSrc + i), sign));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, m);
+    peak = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+#elif defined(SIMD_NEON)
+    float32x4_t m = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        m = vmaxq_f32(m, vabsq_f32(vld1q_f32(pSrc + i)));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, m);
+    peak = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+#endif
+
+    for (; i < count; i++) {
+        float level = fabsf(pSrc[i]);
+        if (level > peak) peak = level;
+    }
+
+    return peak;
+}
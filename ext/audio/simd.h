@@ -0,0 +1,55 @@
+// ============================================================================
+// simd.h - Vector kernels with runtime dispatch for native_audio
+// ============================================================================
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Instruction Sets
+// ============================================================================
+
+// SSE2 and NEON are baseline on the 64-bit targets. AVX code is compiled
+// per function with a target attribute and only run after a CPU check.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_AVX 1
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef enum {
+    SIMD_BACKEND_SCALAR,
+    SIMD_BACKEND_SSE2,
+    SIMD_BACKEND_AVX,
+    SIMD_BACKEND_NEON
+} simd_backend;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Kernels start out on the best instruction set the compiler guarantees
+// (SSE2 on x86-64, NEON on ARM64, scalar otherwise). simd_init upgrades
+// them to AVX when the CPU supports it.
+void simd_init(void);
+void simd_use_scalar(ma_bool32 scalar);
+simd_backend simd_get_backend(void);
+const char *simd_backend_name(void);
+
+// pDst[i] += pSrc[i] * gain
+typedef void (*simd_mix_scaled_proc)(float *pDst, const float *pSrc, float gain, ma_uint32 count);
+extern simd_mix_scaled_proc simd_mix_scaled;
+
+// max(|pSrc[i]|)
+float simd_peak(const float *pSrc, ma_uint32 count);
+
+#endif // SIMD_H
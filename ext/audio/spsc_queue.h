@@ -0,0 +1,226 @@
+// ============================================================================
+// spsc_queue.h - Lock-free single-producer/single-consumer ring for native_audio
+// ============================================================================
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "miniaudio.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define SPSC_QUEUE_CAPACITY 2048   // Must be a power of two
+#define PARAM_QUEUE_CAPACITY 128   // Must be a power of two
+#define SPSC_TRIPLE_FRESH 4u       // Flag beside the buffer index
+
+// ============================================================================
+// Atomics
+// ============================================================================
+
+// miniaudio keeps its atomics in the implementation section, so the few we
+// need are defined here. Head and tail are each written by only one side.
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static __forceinline ma_uint32 spsc_load_acquire(const volatile ma_uint32 *p)
+{
+    ma_uint32 value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static __forceinline void spsc_store_release(volatile ma_uint32 *p, ma_uint32 value)
+{
+    _ReadWriteBarrier();
+    *p = value;
+}
+
+static __forceinline ma_uint32 spsc_exchange(volatile ma_uint32 *p, ma_uint32 value)
+{
+    return (ma_uint32)_InterlockedExchange((volatile long *)p, (long)value);
+}
+#else
+static inline ma_uint32 spsc_load_acquire(const volatile ma_uint32 *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void spsc_store_release(volatile ma_uint32 *p, ma_uint32 value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+static inline ma_uint32 spsc_exchange(volatile ma_uint32 *p, ma_uint32 value)
+{
+    return __atomic_exchange_n(p, value, __ATOMIC_ACQ_REL);
+}
+#endif
+
+// ============================================================================
+// Types
+// ============================================================================
+
+typedef struct {
+    ma_uint32 items[SPSC_QUEUE_CAPACITY];
+    volatile ma_uint32 head;        // Next slot to read, owned by the consumer
+    volatile ma_uint32 tail;        // Next slot to write, owned by the producer
+    volatile ma_uint32 dropped;     // Set by the producer when a push didn't fit
+} spsc_queue;
+
+// A parameter change for a DSP node. Commands carry absolute values, so
+// applying a run of them leaves the node as the last one set it.
+typedef struct {
+    ma_uint32 op;       // Node-specific
+    ma_uint32 index;    // Tap, ramp curve or the like, if any
+    ma_uint32 frames;
+    float value;
+} param_command;
+
+// Commands from the Ruby thread to a node's render, which applies them all
+// at the start of its next block
+typedef struct {
+    param_command items[PARAM_QUEUE_CAPACITY];
+    volatile ma_uint32 head;        // Next slot to read, owned by the consumer
+    volatile ma_uint32 tail;        // Next slot to write, owned by the producer
+} param_queue;
+
+// Three buffers handed between a producer and a consumer without either
+// waiting: the producer fills back and swaps it into the middle, the
+// consumer swaps the middle out into front when it's fresh. The caller
+// keeps the buffers; this only tracks which is which.
+typedef struct {
+    volatile ma_uint32 middle;      // Shared buffer index, | SPSC_TRIPLE_FRESH until taken
+    ma_uint32 back;                 // Owned by the producer
+    ma_uint32 front;                // Owned by the consumer
+} spsc_triple;
+
+// ============================================================================
+// Operations
+// ============================================================================
+
+static inline void spsc_queue_init(spsc_queue *q)
+{
+    q->head = 0;
+    q->tail = 0;
+    q->dropped = 0;
+}
+
+// Producer side. Never blocks; a full queue records the drop instead.
+static inline ma_bool32 spsc_queue_push(spsc_queue *q, ma_uint32 value)
+{
+    ma_uint32 tail = q->tail;
+    if (tail - spsc_load_acquire(&q->head) >= SPSC_QUEUE_CAPACITY) {
+        spsc_store_release(&q->dropped, 1);
+        return MA_FALSE;
+    }
+
+    q->items[tail & (SPSC_QUEUE_CAPACITY - 1)] = value;
+    spsc_store_release(&q->tail, tail + 1);
+    return MA_TRUE;
+}
+
+// Consumer side
+static inline ma_bool32 spsc_queue_pop(spsc_queue *q, ma_uint32 *pValue)
+{
+    ma_uint32 head = q->head;
+    if (head == spsc_load_acquire(&q->tail)) {
+        return MA_FALSE;
+    }
+
+    *pValue = q->items[head & (SPSC_QUEUE_CAPACITY - 1)];
+    spsc_store_release(&q->head, head + 1);
+    return MA_TRUE;
+}
+
+// Consumer side. Returns whether any push was dropped since the last call.
+static inline ma_bool32 spsc_queue_take_dropped(spsc_queue *q)
+{
+    if (spsc_load_acquire(&q->dropped) == 0) {
+        return MA_FALSE;
+    }
+
+    spsc_store_release(&q->dropped, 0);
+    return MA_TRUE;
+}
+
+// Only while the consumer can't be running (the node is out of the graph)
+static inline void param_queue_init(param_queue *q)
+{
+    q->head = 0;
+    q->tail = 0;
+}
+
+// Producer side. Never blocks; the caller decides what a full queue means.
+static inline ma_bool32 param_queue_push(param_queue *q, const param_command *pCommand)
+{
+    ma_uint32 tail = q->tail;
+    if (tail - spsc_load_acquire(&q->head) >= PARAM_QUEUE_CAPACITY) {
+        return MA_FALSE;
+    }
+
+    q->items[tail & (PARAM_QUEUE_CAPACITY - 1)] = *pCommand;
+    spsc_store_release(&q->tail, tail + 1);
+    return MA_TRUE;
+}
+
+// Consumer side
+static inline ma_bool32 param_queue_pop(param_queue *q, param_command *pCommand)
+{
+    ma_uint32 head = q->head;
+    if (head == spsc_load_acquire(&q->tail)) {
+        return MA_FALSE;
+    }
+
+    *pCommand = q->items[head & (PARAM_QUEUE_CAPACITY - 1)];
+    spsc_store_release(&q->head, head + 1);
+    return MA_TRUE;
+}
+
+// Consumer side. Skips every command before tail, which the caller has
+// superseded by other means.
+static inline void param_queue_skip_to(param_queue *q, ma_uint32 tail)
+{
+    if ((ma_int32)(tail - q->head) > 0) {
+        spsc_store_release(&q->head, tail);
+    }
+}
+
+// Producer side: the tail the next push writes at
+static inline ma_uint32 param_queue_tail(param_queue *q)
+{
+    return q->tail;
+}
+
+static inline void spsc_triple_init(spsc_triple *t)
+{
+    t->front = 0;
+    t->middle = 1;
+    t->back = 2;
+}
+
+// Producer side: hands over the back buffer once it's filled
+static inline void spsc_triple_publish(spsc_triple *t)
+{
+    t->back = spsc_exchange(&t->middle, t->back | SPSC_TRIPLE_FRESH) & 3u;
+}
+
+// Producer side: whether the last buffer published hasn't been taken yet
+static inline ma_bool32 spsc_triple_pending(spsc_triple *t)
+{
+    return (spsc_load_acquire(&t->middle) & SPSC_TRIPLE_FRESH) != 0;
+}
+
+// Consumer side. Moves the latest published buffer to front; returns
+// false if nothing new was published.
+static inline ma_bool32 spsc_triple_take(spsc_triple *t)
+{
+    if ((spsc_load_acquire(&t->middle) & SPSC_TRIPLE_FRESH) == 0) {
+        return MA_FALSE;
+    }
+
+    t->front = spsc_exchange(&t->middle, t->front) & 3u;
+    return MA_TRUE;
+}
+
+#endif // SPSC_QUEUE_H
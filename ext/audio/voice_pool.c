@@ -0,0 +1,777 @@
+// ============================================================================
+// voice_pool.c - Preallocated per-channel playback voices
+// ============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include "audio.h"
+#include "clip_registry.h"
+#include "spsc_queue.h"
+
+// ============================================================================
+// Pool Storage
+// ============================================================================
+
+static voice *voices[MAX_CHANNELS];
+static int voice_count = 0;
+static ma_engine *pool_engine = NULL;
+
+// Channels whose sound reached its end, pushed from the audio thread
+static spsc_queue finished_channels;
+
+// Idle effect nodes, all created at init so play and the effect calls
+// never allocate. A voice holds at most one of each, so there's a fade
+// and a send per voice; delays (with their 2 s buffers) and reverbs are
+// capped by the effect count and run out when that many are in use.
+static fade_node *free_fades[MAX_CHANNELS];
+static int free_fade_count = 0;
+static multi_tap_delay_node *free_delays[MAX_CHANNELS];
+static int free_delay_count = 0;
+static reverb_node *free_reverbs[MAX_CHANNELS];
+static int free_reverb_count = 0;
+static ma_splitter_node *free_sends[MAX_CHANNELS];
+static int free_send_count = 0;
+
+// Voices keeping a delay or reverb spliced in only while its tail rings out
+static int lingering[MAX_CHANNELS];
+static int lingering_count = 0;
+
+// ============================================================================
+// Effect Node Pools
+// ============================================================================
+
+static fade_node *fade_create(void)
+{
+    fade_node *pNode = (fade_node *)malloc(sizeof(fade_node));
+    if (pNode == NULL) {
+        return NULL;
+    }
+
+    ma_result result = fade_init(pNode, ma_engine_get_node_graph(pool_engine),
+                                 ma_engine_get_sample_rate(pool_engine),
+                                 ma_engine_get_channels(pool_engine));
+    if (result != MA_SUCCESS) {
+        free(pNode);
+        return NULL;
+    }
+
+    return pNode;
+}
+
+static multi_tap_delay_node *delay_create(void)
+{
+    multi_tap_delay_node *pNode = (multi_tap_delay_node *)malloc(sizeof(multi_tap_delay_node));
+    if (pNode == NULL) {
+        return NULL;
+    }
+
+    ma_result result = multi_tap_delay_init(pNode, ma_engine_get_node_graph(pool_engine),
+                                            ma_engine_get_sample_rate(pool_engine),
+                                            ma_engine_get_channels(pool_engine));
+    if (result != MA_SUCCESS) {
+        free(pNode->buffer);
+        free(pNode);
+        return NULL;
+    }
+
+    return pNode;
+}
+
+static reverb_node *reverb_create(void)
+{
+    reverb_node *pNode = (reverb_node *)malloc(sizeof(reverb_node));
+    if (pNode == NULL) {
+        return NULL;
+    }
+
+    ma_result result = reverb_init(pNode, ma_engine_get_node_graph(pool_engine),
+                                   ma_engine_get_sample_rate(pool_engine),
+                                   ma_engine_get_channels(pool_engine));
+    if (result != MA_SUCCESS) {
+        free(pNode);
+        return NULL;
+    }
+
+    return pNode;
+}
+
+static ma_splitter_node *send_create(void)
+{
+    ma_splitter_node *pNode = (ma_splitter_node *)malloc(sizeof(ma_splitter_node));
+    if (pNode == NULL) {
+        return NULL;
+    }
+
+    ma_splitter_node_config config = ma_splitter_node_config_init(ma_engine_get_channels(pool_engine));
+    if (ma_splitter_node_init(ma_engine_get_node_graph(pool_engine), &config, NULL, pNode) != MA_SUCCESS) {
+        free(pNode);
+        return NULL;
+    }
+
+    return pNode;
+}
+
+static void send_destroy(ma_splitter_node *pNode)
+{
+    ma_splitter_node_uninit(pNode, NULL);
+    free(pNode);
+}
+
+// NULL once every node of the kind is in use
+static fade_node *fade_acquire(void)
+{
+    return free_fade_count > 0 ? free_fades[--free_fade_count] : NULL;
+}
+
+static multi_tap_delay_node *delay_acquire(void)
+{
+    return free_delay_count > 0 ? free_delays[--free_delay_count] : NULL;
+}
+
+static reverb_node *reverb_acquire(void)
+{
+    return free_reverb_count > 0 ? free_reverbs[--free_reverb_count] : NULL;
+}
+
+static ma_splitter_node *send_acquire(void)
+{
+    return free_send_count > 0 ? free_sends[--free_send_count] : NULL;
+}
+
+// Nodes must already be out of the graph
+static void fade_release(fade_node *pNode)
+{
+    fade_reset(pNode);
+    free_fades[free_fade_count++] = pNode;
+}
+
+static void delay_release(multi_tap_delay_node *pNode)
+{
+    multi_tap_delay_reset(pNode);
+    free_delays[free_delay_count++] = pNode;
+}
+
+static void reverb_release(reverb_node *pNode)
+{
+    reverb_reset(pNode);
+    free_reverbs[free_reverb_count++] = pNode;
+}
+
+static void send_release(ma_splitter_node *pNode)
+{
+    ma_node_set_output_bus_volume(pNode, 1, 1.0f);
+    free_sends[free_send_count++] = pNode;
+}
+
+// ============================================================================
+// Voice Storage
+// ============================================================================
+
+static void set_lingering(voice *pVoice, ma_bool32 lingers)
+{
+    if (pVoice->lingering == lingers) {
+        return;
+    }
+
+    pVoice->lingering = lingers;
+    if (lingers) {
+        lingering[lingering_count++] = pVoice->channel;
+        return;
+    }
+
+    for (int i = 0; i < lingering_count; i++) {
+        if (lingering[i] == pVoice->channel) {
+            lingering[i] = lingering[--lingering_count];
+            break;
+        }
+    }
+}
+
+// Runs on the audio thread once the sound has stopped at its end
+static void voice_on_end(void *pUserData, ma_sound *pSound)
+{
+    (void)pSound;
+    spsc_queue_push(&finished_channels, (ma_uint32)((voice *)pUserData)->channel);
+}
+
+static voice *voice_create(int channel)
+{
+    voice *pVoice = (voice *)malloc(sizeof(voice));
+    if (pVoice == NULL) {
+        return NULL;
+    }
+
+    memset(pVoice, 0, sizeof(*pVoice));
+    pVoice->channel = channel;
+    pVoice->clip_id = -1;
+    pVoice->send_bus = -1;
+
+    return pVoice;
+}
+
+static void voice_destroy(voice *pVoice)
+{
+    voice_detach(pVoice);
+
+    if (pVoice->clip_id >= 0) {
+        ma_sound_uninit(&pVoice->sound);
+    }
+
+    free(pVoice);
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+// Creates count voices, which are all the channels there are, and
+// effect_count delay and reverb nodes
+ma_result voice_pool_init(ma_engine *pEngine, int count, int effect_count)
+{
+    pool_engine = pEngine;
+    spsc_queue_init(&finished_channels);
+    lingering_count = 0;
+
+    if (count > MAX_CHANNELS) count = MAX_CHANNELS;
+    if (effect_count > count) effect_count = count;
+
+    for (int i = 0; i < count; i++) {
+        voices[i] = voice_create(i);
+        if (voices[i] == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+        voice_count = i + 1;
+
+        fade_node *pFade = fade_create();
+        ma_splitter_node *pSend = send_create();
+
+        if (pFade != NULL) free_fades[free_fade_count++] = pFade;
+        if (pSend != NULL) free_sends[free_send_count++] = pSend;
+
+        if (pFade == NULL || pSend == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+    }
+
+    for (int i = 0; i < effect_count; i++) {
+        multi_tap_delay_node *pDelay = delay_create();
+        reverb_node *pReverb = reverb_create();
+
+        if (pDelay != NULL) free_delays[free_delay_count++] = pDelay;
+        if (pReverb != NULL) free_reverbs[free_reverb_count++] = pReverb;
+
+        if (pDelay == NULL || pReverb == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+    }
+
+    return MA_SUCCESS;
+}
+
+void voice_pool_uninit(void)
+{
+    // Destroying a voice hands its effect nodes back to the pools
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (voices[i] != NULL) {
+            voice_destroy(voices[i]);
+            voices[i] = NULL;
+        }
+    }
+
+    while (free_fade_count > 0) {
+        fade_node *pNode = free_fades[--free_fade_count];
+        fade_uninit(pNode);
+        free(pNode);
+    }
+
+    while (free_delay_count > 0) {
+        multi_tap_delay_node *pNode = free_delays[--free_delay_count];
+        multi_tap_delay_uninit(pNode);
+        free(pNode);
+    }
+
+    while (free_reverb_count > 0) {
+        reverb_node *pNode = free_reverbs[--free_reverb_count];
+        reverb_uninit(pNode);
+        free(pNode);
+    }
+
+    while (free_send_count > 0) {
+        send_destroy(free_sends[--free_send_count]);
+    }
+
+    voice_count = 0;
+    pool_engine = NULL;
+}
+
+// ============================================================================
+// Voice Access
+// ============================================================================
+
+// Channels 0 to size - 1 have a voice
+int voice_pool_size(void)
+{
+    return voice_count;
+}
+
+// NULL past the end of the pool
+voice *voice_pool_peek(int channel)
+{
+    return voices[channel];
+}
+
+// Pops a channel whose sound ended. Entries can be stale (the channel may
+// have been stopped or replayed since), so callers must re-check the sound.
+ma_bool32 voice_pool_pop_finished(int *pChannel)
+{
+    ma_uint32 channel;
+    if (!spsc_queue_pop(&finished_channels, &channel)) {
+        return MA_FALSE;
+    }
+
+    *pChannel = (int)channel;
+    return MA_TRUE;
+}
+
+// True if end events were lost to a full queue since the last call
+ma_bool32 voice_pool_finished_overflowed(void)
+{
+    return spsc_queue_take_dropped(&finished_channels);
+}
+
+// ============================================================================
+// Voice Control
+// ============================================================================
+
+// Holds the decoded audio while a voice's copy is re-initialized, so a
+// clip that has since been unloaded isn't freed in between
+static ma_sound relay_sound;
+
+// Re-initializes a bypassed voice's copy with the resampler on. Whatever
+// the sound was doing carries over; the graph link is made again.
+static ma_result voice_enable_resampler(voice *pVoice)
+{
+    ma_sound *pSound = &pVoice->sound;
+    ma_result result = ma_sound_init_copy(pool_engine, pSound, MA_SOUND_FLAG_NO_DEFAULT_ATTACHMENT, NULL, &relay_sound);
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    ma_uint64 cursor = 0;
+    ma_sound_get_cursor_in_pcm_frames(pSound, &cursor);
+    ma_node_state state = ma_node_get_state(pSound);
+    ma_uint64 start_time = ma_node_get_state_time(pSound, ma_node_state_started);
+    ma_uint64 stop_time = ma_node_get_state_time(pSound, ma_node_state_stopped);
+    float volume = ma_sound_get_volume(pSound);
+    float pan = ma_sound_get_pan(pSound);
+    float pitch = ma_sound_get_pitch(pSound);
+    ma_vec3f position = ma_sound_get_position(pSound);
+    ma_bool32 looping = ma_sound_is_looping(pSound);
+
+    ma_sound_uninit(pSound);
+    result = ma_sound_init_copy(pool_engine, &relay_sound, MA_SOUND_FLAG_NO_DEFAULT_ATTACHMENT, NULL, pSound);
+    ma_sound_uninit(&relay_sound);
+    if (result != MA_SUCCESS) {
+        if (pVoice->attached) {
+            clip_registry_detach(pVoice->clip_id);
+        }
+        pVoice->clip_id = -1;
+        pVoice->sound_target = NULL;
+        return result;
+    }
+
+    ma_sound_set_end_callback(pSound, voice_on_end, pVoice);
+    ma_sound_seek_to_pcm_frame(pSound, cursor);
+    ma_sound_set_volume(pSound, volume);
+    ma_sound_set_pan(pSound, pan);
+    ma_sound_set_pitch(pSound, pitch);
+    ma_sound_set_position(pSound, position.x, position.y, position.z);
+    ma_sound_set_looping(pSound, looping);
+    ma_node_set_state_time(pSound, ma_node_state_started, start_time);
+    ma_node_set_state_time(pSound, ma_node_state_stopped, stop_time);
+
+    if (pVoice->sound_target != NULL) {
+        ma_node_attach_output_bus((ma_node *)pSound, 0, pVoice->sound_target, 0);
+    }
+    ma_node_set_state(pSound, state);
+
+    pVoice->resampler_bypassed = MA_FALSE;
+    return MA_SUCCESS;
+}
+
+// engine_format marks a clip already decoded at the engine's sample rate
+// and channel count. Its copies are made with MA_SOUND_FLAG_NO_PITCH, so
+// unpitched playback is a straight copy.
+ma_result voice_load_clip(voice *pVoice, ma_sound *pClip, const char *stream_path, int clip_id, ma_bool32 engine_format)
+{
+    ma_bool32 bypass = engine_format && stream_path == NULL;
+
+    if (pVoice->clip_id == clip_id) {
+        // Same clip: rewind and restore what a fresh copy would start with.
+        // The voice is detached, so the mixer isn't reading it: the data
+        // source is sought directly, and the frames read ahead into the
+        // sound's cache and the pitch resampler, which would otherwise open
+        // the replay, are dropped. A copy whose resampler was switched on
+        // keeps it running.
+        ma_sound_stop(&pVoice->sound);
+        ma_data_source_seek_to_pcm_frame(ma_sound_get_data_source(&pVoice->sound), 0);
+        pVoice->sound.processingCacheFramesRemaining = 0;
+        ma_resampler_reset(&pVoice->sound.engineNode.resampler);
+        ma_sound_reset_start_time(&pVoice->sound);
+        ma_sound_reset_stop_time_and_fade(&pVoice->sound);
+        ma_sound_set_volume(&pVoice->sound, 1.0f);
+        ma_sound_set_pitch(&pVoice->sound, 1.0f);
+        ma_sound_set_pan(&pVoice->sound, 0.0f);
+        ma_sound_set_position(&pVoice->sound, 0.0f, 0.0f, 0.0f);
+        ma_sound_set_looping(&pVoice->sound, ma_sound_is_looping(pClip));
+        return MA_SUCCESS;
+    }
+
+    if (pVoice->clip_id >= 0) {
+        ma_sound_uninit(&pVoice->sound);
+        pVoice->clip_id = -1;
+        pVoice->sound_target = NULL;
+    }
+
+    ma_result result;
+    if (stream_path != NULL) {
+        // Streams can't be copied, so each voice opens its own. The first
+        // pages decode on a job thread rather than stalling play.
+        result = ma_sound_init_from_file(pool_engine, stream_path,
+                                         MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC | MA_SOUND_FLAG_NO_DEFAULT_ATTACHMENT,
+                                         NULL, NULL, &pVoice->sound);
+        if (result == MA_SUCCESS) {
+            ma_sound_set_looping(&pVoice->sound, ma_sound_is_looping(pClip));
+        }
+    } else {
+        ma_uint32 flags = MA_SOUND_FLAG_NO_DEFAULT_ATTACHMENT | (engine_format ? MA_SOUND_FLAG_NO_PITCH : 0);
+        result = ma_sound_init_copy(pool_engine, pClip, flags, NULL, &pVoice->sound);
+    }
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    ma_sound_set_end_callback(&pVoice->sound, voice_on_end, pVoice);
+
+    pVoice->clip_id = clip_id;
+    pVoice->resampler_bypassed = bypass;
+
+    return MA_SUCCESS;
+}
+
+// The bypassed resampler is switched on by the first pitch other than 1
+// and then left running until the voice plays a different clip: re-making
+// the copy back and forth would click mid-sound and allocate on replay. If
+// the copy can't be made again the voice is left without a clip.
+ma_result voice_set_pitch(voice *pVoice, float pitch)
+{
+    ma_sound_set_pitch(&pVoice->sound, pitch);
+
+    if (pVoice->resampler_bypassed && pitch != 1.0f) {
+        return voice_enable_resampler(pVoice);
+    }
+
+    return MA_SUCCESS;
+}
+
+// Once a fade node has taken over, volume and pan only change through it
+void voice_set_volume(voice *pVoice, float volume)
+{
+    if (pVoice->fade != NULL) {
+        fade_ramp_volume(pVoice->fade, volume, 0, RAMP_LINEAR);
+    } else {
+        ma_sound_set_volume(&pVoice->sound, volume);
+    }
+}
+
+void voice_set_pan(voice *pVoice, float pan)
+{
+    if (pVoice->fade != NULL) {
+        fade_ramp_pan(pVoice->fade, pan, 0);
+    } else {
+        ma_sound_set_pan(&pVoice->sound, pan);
+    }
+}
+
+// Frees the voice's copy of its clip. The voice must be detached.
+void voice_release_clip(voice *pVoice)
+{
+    if (pVoice->clip_id < 0) {
+        return;
+    }
+
+    ma_sound_uninit(&pVoice->sound);
+    pVoice->clip_id = -1;
+    pVoice->sound_target = NULL;
+}
+
+// Routes the voice to the engine endpoint. The sound must be loaded.
+void voice_attach(voice *pVoice)
+{
+    if (!pVoice->attached) {
+        clip_registry_attach(pVoice->clip_id);
+    }
+    pVoice->attached = MA_TRUE;
+    voice_route(pVoice);
+}
+
+// Silences the voice, takes its chain out of the graph and returns its effect
+// nodes to the pools. Detaching blocks until the audio thread has finished
+// with each node, so they are safe to reset afterwards.
+void voice_detach(voice *pVoice)
+{
+    if (pVoice->clip_id >= 0) {
+        ma_sound_stop(&pVoice->sound);
+
+        if (pVoice->sound_target != NULL) {
+            ma_node_detach_output_bus((ma_node *)&pVoice->sound, 0);
+            pVoice->sound_target = NULL;
+        }
+    }
+
+    if (pVoice->fade != NULL) {
+        if (pVoice->fade_target != NULL) {
+            ma_node_detach_output_bus(&pVoice->fade->base, 0);
+            pVoice->fade_target = NULL;
+        }
+        fade_release(pVoice->fade);
+        pVoice->fade = NULL;
+    }
+
+    if (pVoice->delay != NULL) {
+        if (pVoice->delay_target != NULL) {
+            ma_node_detach_output_bus(&pVoice->delay->base, 0);
+            pVoice->delay_target = NULL;
+        }
+        delay_release(pVoice->delay);
+        pVoice->delay = NULL;
+    }
+
+    if (pVoice->reverb != NULL) {
+        if (pVoice->reverb_target != NULL) {
+            ma_node_detach_output_bus(&pVoice->reverb->base, 0);
+            pVoice->reverb_target = NULL;
+        }
+        reverb_release(pVoice->reverb);
+        pVoice->reverb = NULL;
+    }
+
+    if (pVoice->send != NULL) {
+        if (pVoice->send_target != NULL) {
+            ma_node_detach_output_bus(pVoice->send, 0);
+            pVoice->send_target = NULL;
+        }
+        if (pVoice->send_bus_target != NULL) {
+            ma_node_detach_output_bus(pVoice->send, 1);
+            pVoice->send_bus_target = NULL;
+        }
+        send_release(pVoice->send);
+        pVoice->send = NULL;
+    }
+
+    pVoice->send_bus = -1;
+    pVoice->send_level = 0.0f;
+    if (pVoice->attached && pVoice->clip_id >= 0) {
+        clip_registry_detach(pVoice->clip_id);
+    }
+    pVoice->attached = MA_FALSE;
+    set_lingering(pVoice, MA_FALSE);
+}
+
+// ============================================================================
+// Effect Chain
+// ============================================================================
+
+// The node takes over the sound's volume and pan where they are, and
+// stays in the chain until the voice is detached
+ma_result voice_ensure_fade(voice *pVoice)
+{
+    if (pVoice->fade == NULL) {
+        pVoice->fade = fade_acquire();
+        if (pVoice->fade == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+
+        fade_take_over(pVoice->fade, &pVoice->sound);
+        voice_route(pVoice);
+    }
+
+    return MA_SUCCESS;
+}
+
+ma_result voice_ensure_delay(voice *pVoice)
+{
+    if (pVoice->delay == NULL) {
+        pVoice->delay = delay_acquire();
+        if (pVoice->delay == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+    }
+
+    return MA_SUCCESS;
+}
+
+ma_result voice_ensure_reverb(voice *pVoice)
+{
+    if (pVoice->reverb == NULL) {
+        pVoice->reverb = reverb_acquire();
+        if (pVoice->reverb == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+    }
+
+    return MA_SUCCESS;
+}
+
+ma_result voice_ensure_send(voice *pVoice)
+{
+    if (pVoice->send == NULL) {
+        pVoice->send = send_acquire();
+        if (pVoice->send == NULL) {
+            return MA_OUT_OF_MEMORY;
+        }
+    }
+
+    return MA_SUCCESS;
+}
+
+ma_result voice_set_send(voice *pVoice, int bus, float level)
+{
+    ma_result result = voice_ensure_send(pVoice);
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    pVoice->send_bus = bus;
+    pVoice->send_level = level;
+    ma_node_set_output_bus_volume(pVoice->send, 1, level);
+    voice_route(pVoice);
+
+    return MA_SUCCESS;
+}
+
+static void route_output(ma_node *pNode, ma_uint32 outputBus, ma_node **ppTarget, ma_node *pNewTarget)
+{
+    if (*ppTarget == pNewTarget) {
+        return;
+    }
+
+    if (pNewTarget != NULL) {
+        ma_node_attach_output_bus(pNode, outputBus, pNewTarget, 0);
+    } else {
+        ma_node_detach_output_bus(pNode, outputBus);
+    }
+
+    *ppTarget = pNewTarget;
+}
+
+// Splices effect nodes in or out of the chain based on whether they would
+// change the signal. Downstream links are made before upstream ones so the
+// sound is never routed into a node that leads nowhere.
+void voice_route(voice *pVoice)
+{
+    if (!pVoice->attached || pVoice->clip_id < 0) {
+        return;
+    }
+
+    // A node with nothing left to do stays in until its tail has died,
+    // so removing the last tap or turning reverb off doesn't cut it short
+    ma_bool32 delay_ringing = pVoice->delay_target != NULL && !multi_tap_delay_is_silent(pVoice->delay);
+    ma_bool32 reverb_ringing = pVoice->reverb_target != NULL && !reverb_is_silent(pVoice->reverb);
+    ma_bool32 delay_active = pVoice->delay != NULL && pVoice->delay->tap_count > 0;
+    ma_bool32 reverb_active = reverb_is_enabled(pVoice->reverb);
+    ma_bool32 use_delay = delay_active || delay_ringing;
+    ma_bool32 use_reverb = reverb_active || reverb_ringing;
+    reverb_node *bus = reverb_bus_get(pVoice->send_bus);
+    ma_bool32 use_send = pVoice->send != NULL && bus != NULL && pVoice->send_level > 0.0f;
+    ma_node *next = ma_engine_get_endpoint(pool_engine);
+
+    if (use_send) {
+        route_output(pVoice->send, 1, &pVoice->send_bus_target, &bus->base);
+        route_output(pVoice->send, 0, &pVoice->send_target, next);
+        next = pVoice->send;
+    }
+
+    if (use_reverb) {
+        route_output(&pVoice->reverb->base, 0, &pVoice->reverb_target, next);
+        next = &pVoice->reverb->base;
+    }
+
+    if (use_delay) {
+        if (pVoice->delay_target == NULL) {
+            // History from before the node was bypassed is no longer contiguous
+            multi_tap_delay_clear_history(pVoice->delay);
+        }
+        route_output(&pVoice->delay->base, 0, &pVoice->delay_target, next);
+        next = &pVoice->delay->base;
+    }
+
+    if (pVoice->fade != NULL) {
+        route_output(&pVoice->fade->base, 0, &pVoice->fade_target, next);
+        next = &pVoice->fade->base;
+    }
+
+    route_output((ma_node *)&pVoice->sound, 0, &pVoice->sound_target, next);
+
+    // Unused nodes are only cut loose once nothing upstream feeds them
+    if (!use_delay && pVoice->delay != NULL) {
+        route_output(&pVoice->delay->base, 0, &pVoice->delay_target, NULL);
+    }
+
+    if (!use_reverb && pVoice->reverb != NULL) {
+        route_output(&pVoice->reverb->base, 0, &pVoice->reverb_target, NULL);
+    }
+
+    if (!use_send && pVoice->send != NULL) {
+        route_output(pVoice->send, 0, &pVoice->send_target, NULL);
+        route_output(pVoice->send, 1, &pVoice->send_bus_target, NULL);
+    }
+
+    set_lingering(pVoice, (use_delay && !delay_active) || (use_reverb && !reverb_active));
+}
+
+// Cleanup pass: splices out the nodes whose tails have died since they
+// were last routed
+void voice_pool_route_lingering(void)
+{
+    for (int i = lingering_count - 1; i >= 0; i--) {
+        if (i < lingering_count) {
+            voice_route(voices[lingering[i]]);
+        }
+    }
+}
+
+// ============================================================================
+// Tail Tracking
+// ============================================================================
+
+// Upper bound on how long the chain keeps sounding once the sound stops.
+// A bus send hands its tail to the bus, so it doesn't hold the voice.
+ma_uint64 voice_tail_frames(voice *pVoice)
+{
+    ma_uint64 frames = 0;
+
+    if (pVoice->delay_target != NULL) {
+        frames += multi_tap_delay_tail_frames(pVoice->delay);
+    }
+
+    if (pVoice->reverb_target != NULL) {
+        frames += reverb_tail_frames(pVoice->reverb);
+    }
+
+    return frames;
+}
+
+// True once every effect in the chain has decayed below the silence threshold
+ma_bool32 voice_tail_is_silent(voice *pVoice)
+{
+    if (pVoice->delay_target != NULL && !multi_tap_delay_is_silent(pVoice->delay)) {
+        return MA_FALSE;
+    }
+
+    if (pVoice->reverb_target != NULL && !reverb_is_silent(pVoice->reverb)) {
+        return MA_FALSE;
+    }
+
+    return MA_TRUE;
+}
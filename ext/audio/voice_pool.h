@@ -0,0 +1,89 @@
+// ============================================================================
+// voice_pool.h - Preallocated per-channel playback voices for native_audio
+// ============================================================================
+
+#ifndef VOICE_POOL_H
+#define VOICE_POOL_H
+
+#include "miniaudio.h"
+#include "delay_node.h"
+#include "fade_node.h"
+#include "reverb_node.h"
+#include "reverb_bus.h"
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+#define DEFAULT_EFFECT_POOL_SIZE 16   // Delay and reverb nodes
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// Everything a channel needs to play a clip. Voices are created once and
+// reused; the sound copy is kept across plays of an unpitched engine-format
+// clip and made again otherwise.
+// Fade, delay and reverb nodes are borrowed from shared pools on first use
+// and only spliced into the chain while they have something to do, or a
+// tail left to ring out:
+//
+//   sound -> [fade] -> [delay] -> [reverb] -> [send] -> endpoint
+//                                               '----> reverb bus (scaled by send_level)
+typedef struct {
+    ma_sound sound;
+    int channel;
+    int clip_id;                    // Clip loaded into sound, -1 if none
+    ma_bool32 attached;             // Chain is in the graph (playing or draining)
+    ma_bool32 resampler_bypassed;   // Engine-format clip still at pitch 1
+    ma_bool32 lingering;            // A removed delay or reverb is ringing out
+
+    fade_node *fade;                // Borrowed, NULL until volume or pan is ramped
+    multi_tap_delay_node *delay;    // Borrowed, NULL until a tap is added
+    reverb_node *reverb;            // Borrowed, NULL until reverb is touched
+    ma_splitter_node *send;         // Borrowed, NULL until a bus send is set
+    int send_bus;                   // Reverb bus fed by the send, -1 if none
+    float send_level;
+
+    // Current output target of each chain stage, NULL if detached
+    ma_node *sound_target;
+    ma_node *fade_target;
+    ma_node *delay_target;
+    ma_node *reverb_target;
+    ma_node *send_target;           // Splitter output 0 (dry path)
+    ma_node *send_bus_target;       // Splitter output 1 (bus path)
+} voice;
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ma_result voice_pool_init(ma_engine *pEngine, int count, int effect_count);
+void voice_pool_uninit(void);
+
+int voice_pool_size(void);
+voice *voice_pool_peek(int channel);
+
+ma_bool32 voice_pool_pop_finished(int *pChannel);
+ma_bool32 voice_pool_finished_overflowed(void);
+
+ma_result voice_load_clip(voice *pVoice, ma_sound *pClip, const char *stream_path, int clip_id, ma_bool32 engine_format);
+void voice_release_clip(voice *pVoice);
+ma_result voice_set_pitch(voice *pVoice, float pitch);
+void voice_set_volume(voice *pVoice, float volume);
+void voice_set_pan(voice *pVoice, float pan);
+void voice_attach(voice *pVoice);
+void voice_detach(voice *pVoice);
+
+ma_result voice_ensure_fade(voice *pVoice);
+ma_result voice_ensure_delay(voice *pVoice);
+ma_result voice_ensure_reverb(voice *pVoice);
+ma_result voice_ensure_send(voice *pVoice);
+ma_result voice_set_send(voice *pVoice, int bus, float level);
+void voice_route(voice *pVoice);
+void voice_pool_route_lingering(void);
+
+ma_uint64 voice_tail_frames(voice *pVoice);
+ma_bool32 voice_tail_is_silent(voice *pVoice);
+
+#endif // VOICE_POOL_H
@@ -0,0 +1,131 @@
+// ============================================================================
+// wav_map.c - Plays uncompressed WAV data straight from a file mapping
+// ============================================================================
+
+#include <string.h>
+#include "wav_map.h"
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+#define WAVE_FORMAT_PCM         0x0001
+#define WAVE_FORMAT_IEEE_FLOAT  0x0003
+#define WAVE_FORMAT_EXTENSIBLE  0xFFFE
+
+// WAV is little-endian, and so is every platform miniaudio plays on
+static ma_uint16 read_u16(const unsigned char *p)
+{
+    return (ma_uint16)(p[0] | (p[1] << 8));
+}
+
+static ma_uint32 read_u32(const unsigned char *p)
+{
+    return (ma_uint32)p[0] | ((ma_uint32)p[1] << 8) | ((ma_uint32)p[2] << 16) | ((ma_uint32)p[3] << 24);
+}
+
+// Sample formats the resource manager can play without conversion
+static ma_format wav_sample_format(ma_uint16 tag, ma_uint16 bits)
+{
+    if (tag == WAVE_FORMAT_PCM) {
+        switch (bits) {
+            case 8:  return ma_format_u8;
+            case 16: return ma_format_s16;
+            case 24: return ma_format_s24;
+            case 32: return ma_format_s32;
+        }
+    } else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32) {
+        return ma_format_f32;
+    }
+
+    return ma_format_unknown;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ma_bool32 wav_parse(const void *pFile, size_t size, ma_uint32 channels, ma_uint32 sampleRate, mapped_pcm *pPCM)
+{
+    const unsigned char *pData = (const unsigned char *)pFile;
+
+    if (size < 12 || memcmp(pData, "RIFF", 4) != 0 || memcmp(pData + 8, "WAVE", 4) != 0) {
+        return MA_FALSE;
+    }
+
+    ma_format format = ma_format_unknown;
+    ma_uint32 file_channels = 0;
+    ma_uint32 file_rate = 0;
+    ma_uint32 block_align = 0;
+    size_t data_offset = 0;
+    size_t data_size = 0;
+
+    // Chunks are word aligned. The fmt chunk comes before data in any file
+    // worth mapping.
+    size_t offset = 12;
+    while (offset + 8 <= size) {
+        const unsigned char *pChunk = pData + offset;
+        size_t chunk_size = read_u32(pChunk + 4);
+        size_t body = offset + 8;
+
+        if (memcmp(pChunk, "fmt ", 4) == 0 && chunk_size >= 16 && body + chunk_size <= size) {
+            ma_uint16 tag = read_u16(pData + body);
+            ma_uint16 bits = read_u16(pData + body + 14);
+
+            if (tag == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 40) {
+                tag = read_u16(pData + body + 24);  // First two bytes of the subformat GUID
+            }
+
+            format = wav_sample_format(tag, bits);
+            file_channels = read_u16(pData + body + 2);
+            file_rate = read_u32(pData + body + 4);
+            block_align = read_u16(pData + body + 12);
+        } else if (memcmp(pChunk, "data", 4) == 0) {
+            data_offset = body;
+            // Files written by a recorder that never finished report a
+            // bogus size; play what's actually there
+            data_size = (chunk_size <= size - body) ? chunk_size : size - body;
+            break;
+        }
+
+        offset = body + chunk_size + (chunk_size & 1);
+    }
+
+    ma_uint32 sample_bytes = ma_get_bytes_per_sample(format);
+    ma_bool32 playable = format != ma_format_unknown &&
+                         data_offset > 0 &&
+                         file_channels > 0 &&
+                         (channels == 0 || file_channels == channels) &&
+                         file_rate == sampleRate &&
+                         block_align == file_channels * sample_bytes &&
+                         data_size >= block_align &&
+                         (size_t)(pData + data_offset) % (sample_bytes == 3 ? 1 : sample_bytes) == 0;  // Readable in place
+
+    if (!playable) {
+        return MA_FALSE;
+    }
+
+    memset(pPCM, 0, sizeof(*pPCM));
+    pPCM->pFrames = pData + data_offset;
+    pPCM->frameCount = data_size / block_align;
+    pPCM->format = format;
+    pPCM->channels = file_channels;
+    pPCM->sampleRate = file_rate;
+    return MA_TRUE;
+}
+
+ma_bool32 wav_map_open(const char *path, ma_uint32 channels, ma_uint32 sampleRate, mapped_pcm *pPCM)
+{
+    file_map map;
+    if (!file_map_open(path, &map)) {
+        return MA_FALSE;
+    }
+
+    if (!wav_parse(map.pData, map.size, channels, sampleRate, pPCM)) {
+        file_map_close(&map);
+        return MA_FALSE;
+    }
+
+    pPCM->map = map;
+    return MA_TRUE;
+}
@@ -0,0 +1,25 @@
+// ============================================================================
+// wav_map.h - Plays uncompressed WAV data straight from a file mapping
+// ============================================================================
+
+#ifndef WAV_MAP_H
+#define WAV_MAP_H
+
+#include "miniaudio.h"
+#include "file_map.h"
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Maps a PCM or float WAV file whose samples can be played as they are: a
+// format miniaudio reads natively, at sampleRate, with the given channel
+// count (0 for any). The frames point into the data chunk; close them with
+// file_map_close. Anything else fails, and the caller decodes as usual.
+ma_bool32 wav_map_open(const char *path, ma_uint32 channels, ma_uint32 sampleRate, mapped_pcm *pPCM);
+
+// The same for a WAV file already in memory (a memory clip, or an entry in
+// a mapped bank). The frames point into pData, and pPCM->map is left empty.
+ma_bool32 wav_parse(const void *pData, size_t size, ma_uint32 channels, ma_uint32 sampleRate, mapped_pcm *pPCM);
+
+#endif // WAV_MAP_H
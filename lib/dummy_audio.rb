@@ -6,15 +6,30 @@ require 'set'
 # Has the same interface as the Audio C extension but does nothing.
 module DummyAudio
   @sound_count = 0
+  @bus_count = 0
   @tap_counts = {}
   @active_channels = Set.new
   @channel_freed_callback = nil
+  @clip_memory_budget = 0
+  @pcm_cache_dir = nil
 
-  def self.init
+  def self.init(options = nil)
     nil
   end
 
-  def self.load(path)
+  def self.engine_info
+    { sample_rate: 48_000, channels: 2, voices: 1024, backend: :dummy }
+  end
+
+  def self.stop_device
+    nil
+  end
+
+  def self.start_device
+    nil
+  end
+
+  def self.load(path, stream = false, engine_format = false)
     id = @sound_count
     @sound_count += 1
     id
@@ -24,6 +39,62 @@ module DummyAudio
     5.0
   end
 
+  def self.load_async(path)
+    load(path)
+  end
+
+  def self.load_batch(paths)
+    paths.map { |path| load(path) }
+  end
+
+  def self.load_memory(data, format_hint = nil, stream = false, engine_format = false)
+    load(nil)
+  end
+
+  def self.load_memory_async(data, format_hint = nil)
+    load(nil)
+  end
+
+  def self.load_bank(path)
+    NativeAudio::Bank.names(path).to_h { |name| [name, load(nil)] }
+  end
+
+  def self.unload(clip, handle = nil)
+    nil
+  end
+
+  def self.clip_handle(clip)
+    nil
+  end
+
+  def self.pcm_cache_dir=(dir)
+    @pcm_cache_dir = dir
+  end
+
+  def self.pcm_cache_dir
+    @pcm_cache_dir
+  end
+
+  def self.clip_memory_budget=(bytes)
+    @clip_memory_budget = bytes
+  end
+
+  def self.clip_memory_budget
+    @clip_memory_budget
+  end
+
+  def self.clip_memory_used
+    0
+  end
+
+  def self.loaded?(clip)
+    true
+  end
+
+  def self.wait_load(clip)
+    nil
+  end
+
   def self.play(channel, clip)
     @tap_counts[channel] = 0
     @active_channels << channel
@@ -43,6 +114,27 @@ module DummyAudio
     nil
   end
 
+  def self.time_in_frames
+    0
+  end
+
+  def self.play_at(channel, clip, frame)
+    play(channel, clip)
+  end
+
+  def self.stop_at(channel, frame)
+    nil
+  end
+
+  def self.play_with(channel, clip, params)
+    play(channel, clip)
+    apply(channel, params)
+  end
+
+  def self.apply(channel, params)
+    (params[:delay_taps] || []).map { |time_ms, volume| add_delay_tap(channel, time_ms, volume) }
+  end
+
   def self.set_volume(channel, volume)
     nil
   end
@@ -59,6 +151,14 @@ module DummyAudio
     nil
   end
 
+  def self.fade_volume(channel, volume, time_ms, curve = :linear)
+    nil
+  end
+
+  def self.ramp_pan(channel, pan, time_ms)
+    nil
+  end
+
   def self.seek(channel, seconds)
     nil
   end
@@ -106,6 +206,28 @@ module DummyAudio
     nil
   end
 
+  def self.ramp_reverb_wet(channel, wet, time_ms, curve = :linear)
+    nil
+  end
+
+  def self.ramp_reverb_dry(channel, dry, time_ms, curve = :linear)
+    nil
+  end
+
+  def self.create_reverb_bus
+    id = @bus_count
+    @bus_count += 1
+    id
+  end
+
+  def self.set_reverb_bus(bus, size, damp, wet)
+    nil
+  end
+
+  def self.set_reverb_send(channel, bus, level)
+    nil
+  end
+
   def self.next_free_channel
     (0..1023).find { |i| !@active_channels.include?(i) } || -1
   end
@@ -117,4 +239,11 @@ module DummyAudio
   def self.reset_all_channels
     @active_channels.clear
   end
+
+  def self.render(seconds, path = nil)
+    frames = (seconds * 48_000).round
+    return frames if path
+
+    ("\0" * (frames * 2 * 4)).b
+  end
 end
@@ -1,7 +1,9 @@
 # frozen_string_literal: true
 
+require 'fileutils'
 require_relative './audio'
 require_relative './dummy_audio'
+require_relative './native_audio/bank'
 
 unless ENV['DUMMY_AUDIO_BACKEND'] == 'true'
   Audio.init
@@ -12,17 +14,191 @@ module NativeAudio
     ENV['DUMMY_AUDIO_BACKEND'] == 'true' ? DummyAudio : Audio
   end
 
+  # Restarts the engine with a different device setup. Loading this file
+  # starts it with the defaults, so call this while no clips are loaded:
+  #
+  #   NativeAudio.init(period_ms: 5, profile: :low_latency)
+  #
+  # Options: backend:, sample_rate:, channels:, period_ms:, profile:
+  # (:low_latency or :conservative), voices: and effects:. See engine_info
+  # for what was granted.
+  def self.init(**options)
+    audio_driver.init(options)
+  end
+
+  # The engine's negotiated setup: backend, sample_rate, channels, voices and,
+  # with a device, device_name, profile, period_frames, period_ms and
+  # periods
+  def self.engine_info
+    audio_driver.engine_info
+  end
+
+  # Halts the device, and the engine clock with it, until start_device.
+  # Sources keep their place. render still works while it's stopped.
+  def self.stop_device
+    audio_driver.stop_device
+  end
+
+  def self.start_device
+    audio_driver.start_device
+  end
+
+  # Caps the decoded audio kept in memory, in bytes (0 = no limit). Over
+  # budget, the least recently played clips are freed and decoded again
+  # the next time they're played.
+  def self.clip_memory_budget=(bytes)
+    audio_driver.clip_memory_budget = bytes
+  end
+
+  def self.clip_memory_budget
+    audio_driver.clip_memory_budget
+  end
+
+  # Bytes of decoded audio currently in memory
+  def self.clip_memory_used
+    audio_driver.clip_memory_used
+  end
+
+  # Keeps decoded clips in dir across launches, so later loads of an
+  # unchanged file skip decoding. nil turns the cache off.
+  def self.pcm_cache_dir=(dir)
+    FileUtils.mkdir_p(dir) if dir
+    audio_driver.pcm_cache_dir = dir
+  end
+
+  def self.pcm_cache_dir
+    audio_driver.pcm_cache_dir
+  end
+
+  # Engine time: frames output (or rendered) since init. play_at and
+  # stop_at take frames on this clock.
+  def self.time_in_frames
+    audio_driver.time_in_frames
+  end
+
+  # Renders the mix faster than real time. Returns interleaved 32-bit float
+  # samples, or writes a WAV file and returns the frame count.
+  def self.render(seconds, path = nil)
+    audio_driver.render(seconds, path)
+  end
+
   class Clip
     attr_reader :clip
 
-    def initialize(path)
-      @path = path
-      @clip = NativeAudio.audio_driver.load(path)
+    # Starts decoding on a background thread and returns immediately.
+    # Playing the clip before it's ready waits for the decode to finish.
+    def self.load_async(path)
+      clip = allocate
+      clip.send(:adopt, NativeAudio.audio_driver.load_async(path), path)
+      clip
+    end
+
+    # Loads many files at once, decoding them in parallel on the background
+    # threads. Returns the clips in the order given. A file that fails to
+    # load is yielded with its error and comes back as nil; without a
+    # block, the first error is raised once every load has finished.
+    def self.load_batch(paths)
+      results = NativeAudio.audio_driver.load_batch(paths)
+
+      # Every loaded clip gets its handle before anything is raised, so
+      # the ones that did load are still unloaded when collected
+      clips = results.zip(paths).map do |id, path|
+        next nil if id.is_a?(Exception)
+
+        clip = allocate
+        clip.send(:adopt, id, path)
+        clip
+      end
+
+      results.zip(paths).each do |id, path|
+        next unless id.is_a?(Exception)
+        raise id unless block_given?
+
+        yield path, id
+      end
+
+      clips
+    end
+
+    # Loads every clip in a bank written by NativeAudio::Bank (or
+    # `rake bank[dir,out]`). Returns a Hash of clip name => Clip. The bank
+    # is mapped once and its clips decode in parallel; it stays mapped
+    # until every clip from it has been unloaded.
+    def self.load_bank(path)
+      NativeAudio.audio_driver.load_bank(path.to_s).transform_values do |id|
+        clip = allocate
+        clip.send(:adopt, id, nil)
+        clip
+      end
+    end
+
+    # Decodes an encoded file (WAV, FLAC, MP3, Vorbis) held in a String,
+    # e.g. one read out of a packed archive. format_hint is the file
+    # extension; the data is read in place, so no copy is made.
+    def self.from_memory(data, format_hint = nil, stream: false, async: false, engine_format: false)
+      id = if async
+        raise ArgumentError, "engine_format clips can't be loaded asynchronously" if engine_format
+
+        NativeAudio.audio_driver.load_memory_async(data, format_hint)
+      else
+        NativeAudio.audio_driver.load_memory(data, format_hint, stream, engine_format)
+      end
+
+      clip = allocate
+      clip.send(:adopt, id, nil)
+      clip
+    end
+
+    # With stream: true the file is decoded a little at a time while it
+    # plays instead of all up front. Use it for music and long ambience.
+    #
+    # With engine_format: true the clip is converted to the output's
+    # channel count as well as its sample rate, so sources playing it at
+    # pitch 1.0 skip the per-source resampler. Mono clips take up as much
+    # memory as stereo ones. Use it for short, frequently triggered effects.
+    def initialize(path, stream: false, engine_format: false)
+      adopt(NativeAudio.audio_driver.load(path, stream, engine_format), path)
+    end
+
+    def ready?
+      NativeAudio.audio_driver.loaded?(@clip)
+    end
+
+    # Blocks until decoding is done; other Ruby threads keep running.
+    # Raises if the file couldn't be decoded.
+    def wait
+      NativeAudio.audio_driver.wait_load(@clip)
+      self
     end
 
     def duration
       NativeAudio.audio_driver.duration(@clip)
     end
+
+    # Frees the decoded audio now instead of when the clip is garbage
+    # collected. Sources already playing it finish first. Clips loaded from
+    # the same file or data share their audio, which is only freed once
+    # every one of them has been unloaded.
+    def unload
+      return unless @clip
+
+      NativeAudio.audio_driver.unload(@clip, @handle)
+      @clip = nil
+      @handle = nil
+    end
+
+    def unloaded?
+      @clip.nil?
+    end
+
+    private
+
+    def adopt(id, path)
+      @path = path
+      @clip = id
+      # Unloads the clip when this object is collected
+      @handle = NativeAudio.audio_driver.clip_handle(id)
+    end
   end
 
   class DelayTap
@@ -52,6 +228,32 @@ module NativeAudio
     end
   end
 
+  class ReverbBus
+    attr_reader :name, :id, :room_size, :damping, :wet
+
+    def self.registry
+      @registry ||= {}
+    end
+
+    def self.[](name)
+      registry[name]
+    end
+
+    def initialize(name, room_size: 0.5, damping: 0.3, wet: 0.3)
+      @name = name
+      @id = NativeAudio.audio_driver.create_reverb_bus
+      set(room_size: room_size, damping: damping, wet: wet)
+      self.class.registry[name] = self
+    end
+
+    def set(room_size: @room_size, damping: @damping, wet: @wet)
+      NativeAudio.audio_driver.set_reverb_bus(@id, room_size, damping, wet)
+      @room_size = room_size
+      @damping = damping
+      @wet = wet
+    end
+  end
+
   class AudioSource
     attr_reader :channel
 
@@ -62,10 +264,17 @@ module NativeAudio
       @channel = nil
     end
 
+    # Every parameter set so far goes over with the play, so the first
+    # block is heard with them
     def play
-      acquire_channel unless @channel
-      NativeAudio.audio_driver.play(@channel, @clip.clip)
-      apply_params
+      play_with(playback_params)
+    end
+
+    # Starts on an exact engine frame (see NativeAudio.time_in_frames),
+    # which may land partway through a block. The channel is held from
+    # now; a frame already past plays straight away.
+    def play_at(frame)
+      play_with(playback_params.merge(start_at: frame))
     end
 
     def stop
@@ -75,6 +284,12 @@ module NativeAudio
       @channel = nil
     end
 
+    # Stops on an exact engine frame. The channel is freed by the first
+    # cleanup after that frame, as if the clip had ended there.
+    def stop_at(frame)
+      NativeAudio.audio_driver.stop_at(@channel, frame) if @channel
+    end
+
     def channel_freed
       @channel = nil
     end
@@ -117,6 +332,19 @@ module NativeAudio
       NativeAudio.audio_driver.set_volume(@channel, volume) if @channel
     end
 
+    # Ramps run on the audio thread, one step per sample, so a single call
+    # replaces setting the level every frame. curve: :exponential fades
+    # at a constant rate in dB. A replay starts where the ramp ends.
+    def fade_volume(volume, time_ms, curve: :linear)
+      @params[:volume] = volume
+      NativeAudio.audio_driver.fade_volume(@channel, volume, time_ms, curve) if @channel
+    end
+
+    def ramp_pan(pan, time_ms)
+      @params[:pan] = pan
+      NativeAudio.audio_driver.ramp_pan(@channel, pan, time_ms) if @channel
+    end
+
     def set_pitch(pitch)
       @params[:pitch] = pitch
       NativeAudio.audio_driver.set_pitch(@channel, pitch) if @channel
@@ -134,20 +362,35 @@ module NativeAudio
       tap
     end
 
+    # Parameters replay in the order they were set, so this has to land
+    # after any set_reverb
     def enable_reverb(enabled = true)
+      @params.delete(:reverb_enabled)
       @params[:reverb_enabled] = enabled
       NativeAudio.audio_driver.enable_reverb(@channel, enabled) if @channel
     end
 
     def set_reverb(room_size: 0.5, damping: 0.3, wet: 0.3, dry: 1.0)
+      @params.delete(:reverb_enabled)
       @params[:reverb] = { room_size: room_size, damping: damping, wet: wet, dry: dry }
-      if @channel
-        NativeAudio.audio_driver.enable_reverb(@channel, true)
-        NativeAudio.audio_driver.set_reverb_room_size(@channel, room_size)
-        NativeAudio.audio_driver.set_reverb_damping(@channel, damping)
-        NativeAudio.audio_driver.set_reverb_wet(@channel, wet)
-        NativeAudio.audio_driver.set_reverb_dry(@channel, dry)
-      end
+      NativeAudio.audio_driver.apply(@channel, reverb: @params[:reverb]) if @channel
+    end
+
+    def ramp_reverb_wet(wet, time_ms, curve: :linear)
+      @params[:reverb] = @params[:reverb].merge(wet: wet) if @params[:reverb]
+      NativeAudio.audio_driver.ramp_reverb_wet(@channel, wet, time_ms, curve) if @channel
+    end
+
+    def ramp_reverb_dry(dry, time_ms, curve: :linear)
+      @params[:reverb] = @params[:reverb].merge(dry: dry) if @params[:reverb]
+      NativeAudio.audio_driver.ramp_reverb_dry(@channel, dry, time_ms, curve) if @channel
+    end
+
+    def set_reverb_send(bus, level = 1.0)
+      bus = ReverbBus[bus] unless bus.is_a?(ReverbBus)
+      raise ArgumentError, "Unknown reverb bus" unless bus
+      @params[:reverb_send] = [bus.id, level]
+      NativeAudio.audio_driver.set_reverb_send(@channel, bus.id, level) if @channel
     end
 
     def delay_taps
@@ -156,33 +399,27 @@ module NativeAudio
 
     private
 
+    # A bad parameter raises without playing, and the channel is let go
+    def play_with(params)
+      acquire_channel unless @channel
+      tap_ids = NativeAudio.audio_driver.play_with(@channel, @clip.clip, params)
+      @delay_taps.zip(tap_ids) { |tap, id| tap.id = id }
+    rescue StandardError
+      self.class.owners.delete(@channel)
+      @channel = nil
+      raise
+    end
+
     def acquire_channel
       @channel = NativeAudio.audio_driver.next_free_channel
       raise "No free audio channels available" if @channel < 0
       self.class.owners[@channel] = self
     end
 
-    def apply_params
-      NativeAudio.audio_driver.set_volume(@channel, @params[:volume]) if @params.key?(:volume)
-      NativeAudio.audio_driver.set_pitch(@channel, @params[:pitch]) if @params.key?(:pitch)
-      NativeAudio.audio_driver.set_looping(@channel, @params[:looping]) if @params.key?(:looping)
-      NativeAudio.audio_driver.set_pan(@channel, @params[:pan]) if @params.key?(:pan)
-      NativeAudio.audio_driver.set_pos(@channel, *@params[:pos]) if @params.key?(:pos)
-
-      if @params.key?(:reverb)
-        r = @params[:reverb]
-        NativeAudio.audio_driver.enable_reverb(@channel, true)
-        NativeAudio.audio_driver.set_reverb_room_size(@channel, r[:room_size])
-        NativeAudio.audio_driver.set_reverb_damping(@channel, r[:damping])
-        NativeAudio.audio_driver.set_reverb_wet(@channel, r[:wet])
-        NativeAudio.audio_driver.set_reverb_dry(@channel, r[:dry])
-      elsif @params.key?(:reverb_enabled)
-        NativeAudio.audio_driver.enable_reverb(@channel, @params[:reverb_enabled])
-      end
+    def playback_params
+      return @params if @delay_taps.empty?
 
-      @delay_taps.each do |tap|
-        tap.id = NativeAudio.audio_driver.add_delay_tap(@channel, tap.time_ms, tap.volume)
-      end
+      @params.merge(delay_taps: @delay_taps.map { |tap| [tap.time_ms, tap.volume] })
     end
   end
 
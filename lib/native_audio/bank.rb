@@ -0,0 +1,83 @@
+# frozen_string_literal: true
+
+module NativeAudio
+  # Packs many sound files into one bank file, so loading them takes one
+  # open and one mapping instead of a file per clip. Files are stored as
+  # they are, not decoded. The layout is documented in ext/audio/bank.h.
+  module Bank
+    MAGIC = "NABANK\0\0".b
+    VERSION = 1
+    HEADER_SIZE = 16
+    ENTRY_SIZE = 32
+    FORMAT_CAP = 8
+    ALIGNMENT = 16
+    EXTENSIONS = %w[wav flac mp3 ogg].freeze
+
+    # Writes a bank holding files, a Hash of clip name => source path.
+    # The extension of each source is kept as its format hint.
+    def self.write(path, files)
+      entries = files.map do |name, source|
+        name = name.to_s.encode(Encoding::UTF_8).b
+        format = File.extname(source.to_s).delete_prefix('.').downcase
+        raise ArgumentError, "Format #{format.inspect} is too long for a bank" if format.bytesize > FORMAT_CAP
+
+        { name: name, format: format, data: File.binread(source) }
+      end
+
+      names_offset = HEADER_SIZE + entries.size * ENTRY_SIZE
+      offset = names_offset + entries.sum { |entry| entry[:name].bytesize }
+
+      index = entries.map do |entry|
+        offset = align(offset)
+        record = [offset, entry[:data].bytesize, names_offset, entry[:name].bytesize, entry[:format]].pack('Q<Q<L<L<a8')
+        offset += entry[:data].bytesize
+        names_offset += entry[:name].bytesize
+        record
+      end
+
+      File.open(path, 'wb') do |file|
+        file.write(MAGIC, [VERSION, entries.size].pack('L<L<'), *index)
+        entries.each { |entry| file.write(entry[:name]) }
+        entries.each do |entry|
+          file.write("\0" * (align(file.pos) - file.pos), entry[:data])
+        end
+      end
+
+      path
+    end
+
+    # Packs every sound file under dir. Clips are named by their path
+    # relative to dir, without the extension ("ui/click" for
+    # dir/ui/click.wav).
+    def self.pack_directory(dir, path)
+      files = {}
+
+      Dir.glob("**/*.{#{EXTENSIONS.join(',')}}", base: dir).sort.each do |relative|
+        name = relative.delete_suffix(File.extname(relative))
+        raise ArgumentError, "Two files would both be named #{name.inspect} in the bank" if files.key?(name)
+
+        files[name] = File.join(dir, relative)
+      end
+
+      write(path, files)
+    end
+
+    # Clip names in a bank, in the order they were written
+    def self.names(path)
+      File.open(path, 'rb') do |file|
+        magic, version, count = file.read(HEADER_SIZE).to_s.unpack('a8L<L<')
+        raise ArgumentError, "Not a sound bank: #{path}" unless magic == MAGIC && version == VERSION
+
+        Array.new(count) do
+          _offset, _size, name_offset, name_length = file.read(ENTRY_SIZE).unpack('Q<Q<L<L<')
+          File.binread(path, name_length, name_offset).force_encoding(Encoding::UTF_8)
+        end
+      end
+    end
+
+    def self.align(offset)
+      (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT
+    end
+    private_class_method :align
+  end
+end
@@ -164,6 +164,32 @@ RSpec.describe NativeAudio::AudioSource do
       expect(after_drain.channel).to eq(draining_channel)
     end
 
+    it "reclaims a channel without effects as soon as it stops" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      channel = source.channel
+      source.stop
+
+      other = NativeAudio::AudioSource.new(clip)
+      other.play
+      expect(other.channel).to eq(channel)
+    end
+
+    it "reclaims a channel once its delay tail has died out" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      source.add_delay_tap(time_ms: 50.0, volume: 0.5)
+      channel = source.channel
+      source.stop
+
+      # Well short of REVERB_DRAIN_SECONDS
+      sleep(0.5)
+
+      other = NativeAudio::AudioSource.new(clip)
+      other.play
+      expect(other.channel).to eq(channel)
+    end
+
     it "can play on a channel that is still draining effects" do
       source = NativeAudio::AudioSource.new(clip)
       source.play
@@ -187,6 +213,20 @@ RSpec.describe NativeAudio::AudioSource do
       }.not_to raise_error
     end
 
+    it "cuts draining tails short once every delay node is in use" do
+      20.times do
+        source = NativeAudio::AudioSource.new(clip)
+        source.play
+        source.add_delay_tap(time_ms: 1000.0, volume: 0.9)
+        source.stop
+      end
+
+      # More delays than the 16 made at init; the draining ones give theirs up
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      expect { source.add_delay_tap(time_ms: 100.0, volume: 0.5) }.not_to raise_error
+    end
+
     it "effects on a new source don't crash after reusing a drained channel" do
       # Play and stop with effects to create a draining channel
       old = NativeAudio::AudioSource.new(clip)
@@ -208,6 +248,25 @@ RSpec.describe NativeAudio::AudioSource do
     end
   end
 
+  describe "voice reuse" do
+    it "can replay a different clip on a channel whose voice is cached" do
+      knock = NativeAudio::Clip.new('knock.wav')
+
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      channel = source.channel
+      source.stop
+
+      other = NativeAudio::AudioSource.new(knock)
+      other.play
+      expect(other.channel).to eq(channel)
+      expect { other.set_volume(64) }.not_to raise_error
+
+      again = NativeAudio::AudioSource.new(clip)
+      expect { again.play }.not_to raise_error
+    end
+  end
+
   describe "parameters survive stop/play cycle" do
     it "can set volume, pitch, pan, looping, then stop and play without crashing" do
       source = NativeAudio::AudioSource.new(clip)
@@ -222,6 +281,30 @@ RSpec.describe NativeAudio::AudioSource do
     end
   end
 
+  describe "ramps" do
+    it "can ramp volume, pan and reverb while playing" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      source.set_reverb(wet: 0.3)
+
+      expect {
+        source.fade_volume(0, 200)
+        source.fade_volume(128, 200, curve: :exponential)
+        source.ramp_pan(-1.0, 100)
+        source.set_volume(64)
+        source.ramp_reverb_wet(0.8, 500)
+        source.ramp_reverb_dry(0.5, 500, curve: :exponential)
+      }.not_to raise_error
+    end
+
+    it "rejects an unknown curve" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+
+      expect { source.fade_volume(0, 200, curve: :cubic) }.to raise_error(ArgumentError)
+    end
+  end
+
   describe "pause and resume" do
     it "can pause and resume a playing source" do
       source = NativeAudio::AudioSource.new(clip)
@@ -241,6 +324,33 @@ RSpec.describe NativeAudio::AudioSource do
     end
   end
 
+  describe "reverb buses" do
+    it "can send several sources to a shared bus by name" do
+      bus = NativeAudio::ReverbBus.new(:spec_room, room_size: 0.6, wet: 0.4)
+      a = NativeAudio::AudioSource.new(clip)
+      b = NativeAudio::AudioSource.new(clip)
+      a.play
+      b.play
+
+      expect { a.set_reverb_send(bus, 0.5) }.not_to raise_error
+      expect { b.set_reverb_send(:spec_room, 0.2) }.not_to raise_error
+      expect { bus.set(room_size: 0.9) }.not_to raise_error
+      expect { a.set_reverb_send(bus, 0.0) }.not_to raise_error
+    end
+
+    it "rejects unknown parameters" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      expect { NativeAudio.audio_driver.apply(source.channel, loudness: 3) }.to raise_error(ArgumentError)
+    end
+
+    it "rejects an unknown bus" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      expect { source.set_reverb_send(:nowhere, 0.5) }.to raise_error(ArgumentError)
+    end
+  end
+
   describe "delay taps" do
     it "can add and remove delay taps" do
       source = NativeAudio::AudioSource.new(clip)
@@ -253,6 +363,27 @@ RSpec.describe NativeAudio::AudioSource do
       expect(source.delay_taps.size).to eq(0)
     end
 
+    it "can add a tap again after the last one was removed" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      source.add_delay_tap(time_ms: 200.0, volume: 0.5).remove
+
+      tap = source.add_delay_tap(time_ms: 100.0, volume: 0.4)
+      expect { tap.volume = 0.2 }.not_to raise_error
+      expect(source.delay_taps.size).to eq(1)
+    end
+
+    it "adds its taps again when played again" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      tap = source.add_delay_tap(time_ms: 200.0, volume: 0.5)
+      source.stop
+      source.play
+
+      expect { tap.volume = 0.2 }.not_to raise_error
+      expect(source.delay_taps.size).to eq(1)
+    end
+
     it "can modify delay tap parameters" do
       source = NativeAudio::AudioSource.new(clip)
       source.play
@@ -0,0 +1,47 @@
+require_relative 'spec_helper'
+
+RSpec.describe NativeAudio::Bank, :tmpdir do
+  def pack_sounds
+    sounds = File.join(@dir, 'sounds')
+    FileUtils.mkdir_p(File.join(sounds, 'ui'))
+    FileUtils.cp('tap.wav', File.join(sounds, 'ui'))
+    FileUtils.cp('knock.wav', sounds)
+    FileUtils.cp('boom.wav', sounds)
+    write_wav(File.join(sounds, 'sine.wav'), :f32)
+
+    NativeAudio::Bank.pack_directory(sounds, File.join(@dir, 'sounds.bank'))
+  end
+
+  it "loads every clip in a bank by name" do
+    clips = NativeAudio::Clip.load_bank(pack_sounds)
+
+    expect(clips.keys.sort).to eq(%w[boom knock sine ui/tap])
+    expect(clips['ui/tap'].duration).to be_within(0.001).of(NativeAudio::Clip.new('tap.wav').duration)
+    expect(clips['sine'].duration).to be_within(0.001).of(0.1)
+  end
+
+  it "plays clips straight from the bank" do
+    NativeAudio::AudioSource.new(NativeAudio::Clip.load_bank(pack_sounds)['sine']).play
+
+    # The voice's resampler holds back one frame
+    played = NativeAudio.render(0.05).unpack('e*').each_slice(2).map(&:first).drop(1)
+    expect(played.zip(samples).map { |a, b| (a - b).abs }.max).to be < 1e-6
+  end
+
+  it "rejects files that aren't banks" do
+    expect { NativeAudio::Clip.load_bank('tap.wav') }.to raise_error(RuntimeError, /Not a sound bank/)
+
+    # An index pointing past the end of the file
+    bank = File.binread(pack_sounds)
+    bank[16, 8] = [bank.bytesize].pack('Q<')
+    File.binwrite(File.join(@dir, 'broken.bank'), bank)
+    expect { NativeAudio::Clip.load_bank(File.join(@dir, 'broken.bank')) }.to raise_error(RuntimeError, /Not a sound bank/)
+  end
+
+  it "refuses two files that would share a name" do
+    FileUtils.cp('tap.wav', File.join(@dir, 'tap.wav'))
+    FileUtils.cp('tap.wav', File.join(@dir, 'tap.ogg'))
+
+    expect { NativeAudio::Bank.pack_directory(@dir, File.join(@dir, 'out.bank')) }.to raise_error(ArgumentError)
+  end
+end
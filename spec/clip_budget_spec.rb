@@ -0,0 +1,37 @@
+require_relative 'spec_helper'
+
+RSpec.describe "NativeAudio.clip_memory_budget" do
+  after(:each) do
+    NativeAudio.clip_memory_budget = 0
+  end
+
+  it "counts the decoded size of loaded clips" do
+    # Unique bytes, so no other load shares the clip
+    clip = NativeAudio::Clip.from_memory(File.binread('knock.wav') + 'budget', 'wav')
+    loaded = NativeAudio.clip_memory_used
+    clip.unload
+
+    expect(loaded - NativeAudio.clip_memory_used).to be > 0
+  end
+
+  it "evicts the least recently played clips to stay under budget" do
+    clips = %w[tap.wav knock.wav boom.wav].map { |path| NativeAudio::Clip.new(path) }
+    NativeAudio.clip_memory_budget = 1
+
+    expect(NativeAudio.clip_memory_used).to eq(0)
+    clips.each(&:unload)
+  end
+
+  it "decodes an evicted clip again when it's played" do
+    clip = NativeAudio::Clip.new('tap.wav')
+    NativeAudio.clip_memory_budget = 1
+    NativeAudio.clip_memory_budget = 0
+
+    NativeAudio::AudioSource.new(clip).play
+    sleep 0.05
+
+    expect(NativeAudio.clip_memory_used).to be > 0
+    expect(peak(NativeAudio.render(0.1))).to be > 0.01
+    expect(clip.duration).to be > 0
+  end
+end
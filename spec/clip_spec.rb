@@ -10,4 +10,150 @@ RSpec.describe NativeAudio::Clip do
   it "returns a positive duration" do
     expect(clip.duration).to be > 0
   end
+
+  it "opens a clip for streaming" do
+    streamed = NativeAudio::Clip.new('boom.wav', stream: true)
+    expect(streamed.duration).to be_within(0.001).of(NativeAudio::Clip.new('boom.wav').duration)
+  end
+
+  it "converts a clip to the engine format" do
+    converted = NativeAudio::Clip.new('tap.wav', engine_format: true)
+
+    expect(converted.clip).not_to eq(clip.clip)
+    expect(converted.duration).to be_within(0.001).of(clip.duration)
+    expect { NativeAudio::Clip.new('tap.wav', stream: true, engine_format: true) }.to raise_error(ArgumentError)
+  end
+
+  describe "#unload" do
+    it "frees the slot for the next clip" do
+      id = clip.clip
+      clip.unload
+
+      expect(clip.unloaded?).to be true
+      expect(NativeAudio::Clip.new('tap.wav').clip).to eq(id)
+    end
+
+    it "lets a source that is already playing finish" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      clip.unload
+
+      expect(NativeAudio.render(0.05).unpack('e*').map(&:abs).max).to be > 0.01
+      expect { NativeAudio::AudioSource.new(clip).play }.to raise_error
+    end
+
+    it "doesn't hand out a slot still held by a playing voice" do
+      source = NativeAudio::AudioSource.new(clip)
+      source.play
+      id = clip.clip
+      clip.unload
+
+      expect(NativeAudio::Clip.new('knock.wav').clip).not_to eq(id)
+    end
+  end
+
+  it "unloads clips that are garbage collected" do
+    # More than the 1024 slots, so this only passes if slots come back.
+    # Each copy differs in its trailing bytes so they aren't deduplicated.
+    data = File.binread('tap.wav')
+    expect {
+      1500.times do |i|
+        NativeAudio::Clip.from_memory(data + [i].pack('N'), 'wav')
+        GC.start if i % 250 == 0
+      end
+    }.not_to raise_error
+  end
+
+  describe "deduplication" do
+    it "shares a clip between loads of the same file" do
+      expect(NativeAudio::Clip.new('tap.wav').clip).to eq(clip.clip)
+      expect(NativeAudio::Clip.new('./tap.wav').clip).to eq(clip.clip)
+      expect(NativeAudio::Clip.load_async('tap.wav').clip).to eq(clip.clip)
+    end
+
+    it "keeps streamed and decoded loads apart" do
+      expect(NativeAudio::Clip.new('tap.wav', stream: true).clip).not_to eq(clip.clip)
+    end
+
+    it "shares a clip between strings with the same bytes" do
+      data = File.binread('boom.wav')
+      first = NativeAudio::Clip.from_memory(data, 'wav')
+
+      expect(NativeAudio::Clip.from_memory(data.dup, 'wav').clip).to eq(first.clip)
+      expect(NativeAudio::Clip.from_memory(data + "\0", 'wav').clip).not_to eq(first.clip)
+    end
+
+    it "keeps a shared clip loaded until every load is unloaded" do
+      other = NativeAudio::Clip.new('tap.wav')
+      expect(other.clip).to eq(clip.clip)
+      other.unload
+
+      expect(clip.duration).to be > 0
+      NativeAudio::AudioSource.new(clip).play
+    end
+  end
+
+  describe ".from_memory" do
+    let(:data) { File.binread('boom.wav') }
+    let(:duration) { NativeAudio::Clip.new('boom.wav').duration }
+
+    it "decodes a clip held in a string" do
+      expect(NativeAudio::Clip.from_memory(data, 'wav').duration).to be_within(0.001).of(duration)
+    end
+
+    it "streams and loads asynchronously from a string" do
+      expect(NativeAudio::Clip.from_memory(data, stream: true).duration).to be_within(0.001).of(duration)
+      expect(NativeAudio::Clip.from_memory(data, async: true).wait.duration).to be_within(0.001).of(duration)
+    end
+
+    it "raises on data it can't decode" do
+      expect { NativeAudio::Clip.from_memory('not audio' * 100, 'wav') }.to raise_error(RuntimeError)
+    end
+  end
+
+  describe ".load_async" do
+    it "is ready after waiting" do
+      clip = NativeAudio::Clip.load_async('boom.wav')
+      expect(clip.wait).to eq(clip)
+      expect(clip.ready?).to be true
+      expect(clip.duration).to be_within(0.001).of(NativeAudio::Clip.new('boom.wav').duration)
+    end
+
+    it "can be played before it has finished loading" do
+      clip = NativeAudio::Clip.load_async('knock.wav')
+      source = NativeAudio::AudioSource.new(clip)
+      expect { source.play }.not_to raise_error
+      expect(clip.ready?).to be true
+    end
+
+    it "raises when the file can't be loaded" do
+      expect { NativeAudio::Clip.load_async('missing.wav').wait }.to raise_error(RuntimeError, /missing\.wav/)
+    end
+  end
+
+  describe ".load_batch" do
+    let(:paths) { %w[tap.wav knock.wav boom.wav] }
+
+    it "returns ready clips in the order given" do
+      clips = NativeAudio::Clip.load_batch(paths)
+
+      expect(clips.map(&:ready?)).to eq([true, true, true])
+      expect(clips.map(&:duration)).to eq(paths.map { |path| NativeAudio::Clip.new(path).duration })
+    end
+
+    it "yields the files that failed and loads the rest" do
+      failed = []
+      clips = NativeAudio::Clip.load_batch(['tap.wav', 'missing.wav', 'boom.wav']) { |path, error| failed << [path, error] }
+
+      expect(clips[0].duration).to be > 0
+      expect(clips[1]).to be_nil
+      expect(clips[2].duration).to be > 0
+      expect(failed.map(&:first)).to eq(['missing.wav'])
+      expect(failed.first.last).to be_a(RuntimeError)
+    end
+
+    it "raises the first error without a block" do
+      expect { NativeAudio::Clip.load_batch(['tap.wav', 'missing.wav']) }.to raise_error(RuntimeError, /missing\.wav/)
+    end
+  end
 end
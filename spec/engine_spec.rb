@@ -0,0 +1,27 @@
+require_relative 'spec_helper'
+
+RSpec.describe "NativeAudio engine setup" do
+  it "reports what the device granted" do
+    info = NativeAudio.engine_info
+
+    expect(info[:backend]).to eq(:null)
+    expect(info[:sample_rate]).to be > 0
+    expect(info[:channels]).to be > 0
+    expect(info[:period_frames]).to be > 0
+    expect(info[:profile]).to eq(:low_latency)
+    expect(info[:voices]).to eq(1024)
+  end
+
+  it "rejects unknown options" do
+    expect { NativeAudio.init(period: 5) }.to raise_error(ArgumentError)
+    expect { NativeAudio.init(profile: :fast) }.to raise_error(ArgumentError)
+    expect { NativeAudio.init(sample_rate: 100) }.to raise_error(ArgumentError)
+    expect { NativeAudio.init(voices: 0) }.to raise_error(ArgumentError)
+  end
+
+  it "can't be restarted once clips are loaded" do
+    NativeAudio::Clip.new('tap.wav')
+
+    expect { NativeAudio.init(period_ms: 5) }.to raise_error(RuntimeError)
+  end
+end
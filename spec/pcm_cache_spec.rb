@@ -0,0 +1,50 @@
+require_relative 'spec_helper'
+
+RSpec.describe "NativeAudio.pcm_cache_dir", :tmpdir do
+  after(:each) do
+    NativeAudio.pcm_cache_dir = nil
+  end
+
+  # A copy only this example loads, so no other clip shares it
+  def source_file
+    path = File.join(@dir, 'source.wav')
+    FileUtils.cp('tap.wav', path)
+    path
+  end
+
+  it "writes the decoded clip to the cache directory" do
+    NativeAudio.pcm_cache_dir = File.join(@dir, 'cache')
+    NativeAudio::Clip.new(source_file).unload
+
+    expect(Dir[File.join(@dir, 'cache', '*.pcm')].size).to eq(1)
+  end
+
+  it "reads the clip back from the cache instead of decoding it" do
+    path = source_file
+    NativeAudio.pcm_cache_dir = File.join(@dir, 'cache')
+    NativeAudio::Clip.new(path).unload
+
+    # Silence the cached frames; a clip decoded from the source would still be loud
+    cache_file = Dir[File.join(@dir, 'cache', '*.pcm')].first
+    data_offset = File.binread(cache_file, 8, 48).unpack1('Q<')
+    File.binwrite(cache_file, "\0" * (File.size(cache_file) - data_offset), data_offset)
+
+    NativeAudio::AudioSource.new(NativeAudio::Clip.new(path)).play
+    expect(peak(NativeAudio.render(0.1))).to eq(0.0)
+  end
+
+  it "decodes a source rewritten within the same second afresh" do
+    path = source_file
+    File.utime(Time.at(1_700_000_000, 100, :nsec), Time.at(1_700_000_000, 100, :nsec), path)
+    NativeAudio.pcm_cache_dir = File.join(@dir, 'cache')
+    NativeAudio::Clip.new(path).unload
+
+    # Same size, silent samples, and a timestamp in the same second
+    data_offset = File.binread(path).index('data') + 8
+    File.binwrite(path, "\0" * (File.size(path) - data_offset), data_offset)
+    File.utime(Time.at(1_700_000_000, 200, :nsec), Time.at(1_700_000_000, 200, :nsec), path)
+
+    NativeAudio::AudioSource.new(NativeAudio::Clip.new(path)).play
+    expect(peak(NativeAudio.render(0.1))).to eq(0.0)
+  end
+end
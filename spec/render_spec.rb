@@ -0,0 +1,305 @@
+require_relative 'spec_helper'
+require 'tmpdir'
+
+RSpec.describe "NativeAudio.render" do
+  let(:clip) { NativeAudio::Clip.new('tap.wav') }
+
+  # Keeps the device from pulling blocks between renders, so every frame
+  # lands in the render it's checked against
+  before { NativeAudio.stop_device }
+  after { NativeAudio.start_device }
+
+  # The per-sample Schroeder reverb from before the vector comb bank, as
+  # bench/reverb_bench.c keeps it, over interleaved stereo. The lines are
+  # sized as the pool's nodes are, at the default room size; room_size
+  # only sets the feedback.
+  def serial_reverb(input, room_size:, damping:, wet:, dry: 1.0)
+    f32 = ->(x) { [x].pack('e').unpack1('e') }
+    rate = f32.(NativeAudio.engine_info[:sample_rate])
+    combs = [0.0297, 0.0371, 0.0411, 0.0437].map { |t| f32.(f32.(f32.(f32.(t) * 0.5) * 2.0) * rate).to_i }
+    allpasses = [0.005, 0.0017].map { |t| f32.(f32.(t) * rate).to_i }
+    feedback = f32.(0.6 + f32.(f32.(room_size) * f32.(0.35)))
+    damping = f32.(damping)
+
+    (0...2).map do |ch|
+      comb_lines = combs.map { |size| Array.new(size, 0.0) }
+      allpass_lines = allpasses.map { |size| Array.new(size, 0.0) }
+      damped = [0.0] * combs.size
+      frame = 0
+
+      input.each_slice(2).map do |pair|
+        x = pair[ch]
+        sum = 0.0
+        comb_lines.each_with_index do |line, c|
+          out = line[frame % line.size]
+          damped[c] = out * (1.0 - damping) + damped[c] * damping
+          line[frame % line.size] = x + feedback * damped[c]
+          sum += out
+        end
+
+        y = sum * 0.25
+        allpass_lines.each do |line|
+          buffered = line[frame % line.size]
+          line[frame % line.size] = y + 0.5 * buffered
+          y = buffered - 0.5 * y
+        end
+
+        frame += 1
+        x * dry + y * wet
+      end
+    end.transpose.flatten
+  end
+
+  it "returns interleaved stereo float samples for the requested length" do
+    short = NativeAudio.render(0.1)
+    long = NativeAudio.render(0.2)
+
+    expect(short.bytesize % 8).to eq(0)
+    expect(long.bytesize).to be_within(8).of(short.bytesize * 2)
+  end
+
+  it "renders a playing source" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+
+    expect(peak(NativeAudio.render(0.1))).to be > 0.01
+  end
+
+  it "renders a streamed clip" do
+    source = NativeAudio::AudioSource.new(NativeAudio::Clip.new('tap.wav', stream: true))
+    source.play
+    sleep 0.05  # First pages decode on a job thread
+
+    expect(peak(NativeAudio.render(0.1))).to be > 0.01
+  end
+
+  it "renders an engine-format clip like a regular one" do
+    NativeAudio::AudioSource.new(clip).play
+    regular = NativeAudio.render(0.2).unpack('e*')
+    NativeAudio.audio_driver.reset_all_channels
+
+    NativeAudio::AudioSource.new(NativeAudio::Clip.new('tap.wav', engine_format: true)).play
+    converted = NativeAudio.render(0.2).unpack('e*')
+
+    # The bypassed resampler doesn't hold back the one stereo frame the
+    # regular path does
+    difference = converted[0...-2].zip(regular[2..]).map { |a, b| (a - b).abs }.max
+    expect(difference).to be < 0.001
+  end
+
+  it "pitches an engine-format clip" do
+    source = NativeAudio::AudioSource.new(NativeAudio::Clip.new('tap.wav', engine_format: true))
+    source.play
+    source.set_pitch(2.0)
+
+    # Twice the speed, so the ~150 ms clip is over by 100 ms
+    NativeAudio.render(0.1)
+    expect(peak(NativeAudio.render(0.1))).to be < 0.001
+  end
+
+  it "keeps playing an engine-format clip pitched partway through" do
+    source = NativeAudio::AudioSource.new(NativeAudio::Clip.new('tap.wav', engine_format: true))
+    source.play
+    NativeAudio.render(0.02)
+    source.set_pitch(2.0)
+
+    # The transient ~40 ms in now comes 10 ms after the change
+    expect(peak(NativeAudio.render(0.05))).to be > 0.01
+  end
+
+  it "replays a pitched clip on its channel exactly as the first play" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    first = NativeAudio.render(0.2)
+
+    # Cut off mid-sound and pitched, so the resampler holds frames to clear
+    source.play
+    source.set_pitch(1.5)
+    NativeAudio.render(0.02)
+    source.stop
+
+    source.set_pitch(1.0)
+    source.play
+    expect(NativeAudio.render(0.2)).to eq(first)
+  end
+
+  it "applies parameters set before play from the first frame" do
+    NativeAudio::AudioSource.new(clip).play
+    full = NativeAudio.render(0.05).unpack('e*')
+    NativeAudio.audio_driver.reset_all_channels
+
+    source = NativeAudio::AudioSource.new(clip)
+    source.set_volume(64)
+    source.play
+    half = NativeAudio.render(0.05).unpack('e*')
+
+    expect(half.zip(full).map { |a, b| (a - b * 0.5).abs }.max).to be < 1e-6
+  end
+
+  it "fades the volume sample by sample" do
+    NativeAudio::AudioSource.new(clip).play
+    NativeAudio.render(0.02)
+    steady = NativeAudio.render(0.05).unpack('e*')
+    NativeAudio.audio_driver.reset_all_channels
+
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    NativeAudio.render(0.02)
+    source.fade_volume(0, 50)
+    faded = NativeAudio.render(0.05).unpack('e*')
+
+    frames = faded.size / 2
+    expected = steady.each_with_index.map { |sample, i| sample * (1.0 - (i / 2 + 1).fdiv(frames)) }
+    expect(faded.zip(expected).map { |a, b| (a - b).abs }.max).to be < 1e-4
+    expect(peak(NativeAudio.render(0.05))).to eq(0.0)
+  end
+
+  it "fades exponentially at an even rate in dB" do
+    NativeAudio::AudioSource.new(clip).play
+    NativeAudio.render(0.02)
+    steady = NativeAudio.render(0.05).unpack('e*')
+    NativeAudio.audio_driver.reset_all_channels
+
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    NativeAudio.render(0.02)
+    source.fade_volume(0, 50, curve: :exponential)
+    faded = NativeAudio.render(0.05).unpack('e*')
+
+    # Silence counts as -80 dB until the last frame
+    frames = faded.size / 2
+    expected = steady.each_with_index.map { |sample, i| sample * 0.0001**(i / 2 + 1).fdiv(frames) }
+    expected[-2..] = [0.0, 0.0]
+    expect(faded.zip(expected).map { |a, b| (a - b).abs }.max).to be < 1e-4
+  end
+
+  it "doesn't start a play whose parameters are rejected" do
+    channel = NativeAudio.audio_driver.next_free_channel
+
+    expect {
+      NativeAudio.audio_driver.play_with(channel, clip.clip, { volume: 128, loudness: 3 })
+    }.to raise_error(ArgumentError)
+    expect(peak(NativeAudio.render(0.1))).to be < 0.001
+  end
+
+  it "starts a scheduled play on the exact frame" do
+    NativeAudio::AudioSource.new(clip).play
+    now_playing = NativeAudio.render(0.05).unpack('e*')
+    NativeAudio.audio_driver.reset_all_channels
+
+    source = NativeAudio::AudioSource.new(clip)
+    source.play_at(NativeAudio.time_in_frames + 1000)
+    scheduled = NativeAudio.render(0.05).unpack('e*')
+
+    expect(scheduled[0, 2000].map(&:abs).max).to eq(0.0)
+    difference = scheduled[2000..].zip(now_playing).map { |a, b| (a - b).abs }.max
+    expect(difference).to be < 1e-6
+  end
+
+  it "stops a scheduled stop on the exact frame and frees the channel" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    NativeAudio.render(0.05)
+    source.stop_at(NativeAudio.time_in_frames + 1000)
+    samples = NativeAudio.render(0.05).unpack('e*')
+
+    expect(samples[0, 2000].map(&:abs).max).to be > 0.001
+    expect(samples[2000..].map(&:abs).max).to eq(0.0)
+
+    NativeAudio.audio_driver.next_free_channel
+    expect(source.channel).to be_nil
+  end
+
+  it "renders the delay tail after the sound has finished" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    source.add_delay_tap(time_ms: 400.0, volume: 1.0)
+
+    # tap.wav is ~150 ms, so 200-400 ms is silent and the echo follows
+    NativeAudio.render(0.2)
+    gap = NativeAudio.render(0.19)
+    echo = NativeAudio.render(0.1)
+
+    expect(peak(gap)).to be < 0.001
+    expect(peak(echo)).to be > 0.01
+  end
+
+  it "plays out the echo of a tap removed while it's in flight" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    tap = source.add_delay_tap(time_ms: 400.0, volume: 1.0)
+
+    NativeAudio.render(0.2)
+    tap.remove
+    NativeAudio.render(0.19)
+
+    expect(peak(NativeAudio.render(0.1))).to be > 0.01
+  end
+
+  it "rings out the reverb tail after reverb is turned off" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.set_reverb(room_size: 0.9, wet: 0.5)
+    source.play
+
+    # The sound is over by now, so anything left is the tail
+    NativeAudio.render(0.3)
+    source.enable_reverb(false)
+
+    expect(peak(NativeAudio.render(0.1))).to be > 0.001
+  end
+
+  it "renders reverb as the serial loop the comb bank replaced does" do
+    NativeAudio::AudioSource.new(clip).play
+    dry = NativeAudio.render(0.4).unpack('e*')
+    NativeAudio.audio_driver.reset_all_channels
+
+    source = NativeAudio::AudioSource.new(clip)
+    source.set_reverb(room_size: 0.7, damping: 0.5, wet: 0.4)
+    source.play
+    wet = NativeAudio.render(0.4).unpack('e*')
+
+    # Through whichever kernel this CPU picks; NATIVE_AUDIO_NO_SIMD=1 checks the scalar one
+    expected = serial_reverb(dry, room_size: 0.7, damping: 0.5, wet: 0.4)
+    expect(wet.zip(expected).map { |a, b| (a - b).abs }.max).to be < 1e-6
+  end
+
+  it "keeps the last of many tap changes made between blocks" do
+    source = NativeAudio::AudioSource.new(clip)
+    source.play
+    tap = source.add_delay_tap(time_ms: 400.0, volume: 1.0)
+
+    # More changes than the command queue holds; the echo ends up muted
+    300.times { |i| tap.volume = i.even? ? 1.0 : 0.0 }
+
+    NativeAudio.render(0.2)
+    NativeAudio.render(0.19)
+    expect(peak(NativeAudio.render(0.1))).to be < 0.001
+  end
+
+  it "writes a WAV file" do
+    Dir.mktmpdir do |dir|
+      path = File.join(dir, 'out.wav')
+      frames = NativeAudio.render(0.5, path)
+
+      expect(frames).to be > 0
+      header = File.binread(path, 12)
+      expect(header[0, 4]).to eq('RIFF')
+      expect(header[8, 4]).to eq('WAVE')
+      expect(File.size(path)).to be >= frames * 8
+    end
+  end
+
+  it "stops a long render when its thread is killed" do
+    Dir.mktmpdir do |dir|
+      render = Thread.new { NativeAudio.render(3600, File.join(dir, 'long.wav')) }
+      sleep 0.1
+      render.kill
+
+      expect(render.join(5)).not_to be_nil
+    end
+  end
+
+  it "rejects a negative length" do
+    expect { NativeAudio.render(-1) }.to raise_error(ArgumentError)
+  end
+end
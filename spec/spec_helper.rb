@@ -1,8 +1,45 @@
 ENV['NATIVE_AUDIO_DRIVER'] = 'null'
 
+require 'tmpdir'
 require_relative '../lib/native_audio'
 
+module SpecHelpers
+  # Loudest sample in a block from NativeAudio.render
+  def peak(samples)
+    samples.unpack('e*').map(&:abs).max || 0.0
+  end
+
+  # 0.1 s of a sine at half scale, what write_wav writes
+  def samples
+    @samples ||= (0...4800).map { |i| 0.5 * Math.sin(i * 0.05) }
+  end
+
+  # A mono WAV of samples at the 48 kHz the null device runs at, so it
+  # plays as is. format is :f32 or :s16.
+  def write_wav(path, format)
+    tag, bits, data = case format
+      when :s16 then [1, 16, samples.map { |x| (x * 32767).round }.pack('s<*')]
+      when :f32 then [3, 32, samples.pack('e*')]
+    end
+
+    header = ['RIFF', 36 + data.bytesize, 'WAVE', 'fmt ', 16, tag, 1, 48000, 48000 * bits / 8, bits / 8, bits,
+              'data', data.bytesize].pack('a4Va4a4VvvVVvva4V')
+    File.binwrite(path, header + data)
+    path
+  end
+end
+
 RSpec.configure do |config|
+  config.include SpecHelpers
+
+  # Groups tagged :tmpdir get a scratch directory in @dir for each example
+  config.around(:each, :tmpdir) do |example|
+    Dir.mktmpdir do |dir|
+      @dir = dir
+      example.run
+    end
+  end
+
   config.after(:each) do
     NativeAudio::AudioSource.owners.each_value(&:stop)
     NativeAudio::AudioSource.owners.clear
@@ -0,0 +1,24 @@
+require_relative 'spec_helper'
+
+RSpec.describe "Mapped WAV playback", :tmpdir do
+  def rendered_left_channel
+    NativeAudio.render(0.05).unpack('e*').each_slice(2).map(&:first)
+  end
+
+  it "plays float and 16-bit samples as they are" do
+    { f32: 1e-6, s16: 1e-4 }.each do |format, tolerance|
+      clip = NativeAudio::Clip.new(write_wav(File.join(@dir, "#{format}.wav"), format))
+      NativeAudio::AudioSource.new(clip).play
+
+      # The voice's resampler holds back one frame
+      played = rendered_left_channel.drop(1)
+      expect(played.zip(samples).map { |a, b| (a - b).abs }.max).to be < tolerance
+      expect(clip.duration).to be_within(0.001).of(0.1)
+      NativeAudio.audio_driver.reset_all_channels
+    end
+  end
+
+  it "is ready as soon as an async load returns" do
+    expect(NativeAudio::Clip.load_async(write_wav(File.join(@dir, 'async.wav'), :f32)).ready?).to be true
+  end
+end